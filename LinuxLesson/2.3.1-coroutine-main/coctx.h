@@ -0,0 +1,65 @@
+#ifndef COCTX_H
+#define COCTX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * 手写汇编的协程上下文切换（coctx_swap.S），替代 ucontext：
+ *   swapcontext 每次切换都要 rt_sigprocmask 系统调用保存/恢复信号掩码，
+ *   并保存全部通用寄存器与浮点环境；协程切换本质上是一次函数调用，
+ *   调用约定已经允许破坏 caller-saved 寄存器，只需保存 callee-saved 寄存器和栈指针
+ *
+ * 保存内容（压在被切走的协程自己的栈上，上下文里只留一个栈指针）：
+ *   x86-64   rbp rbx r12-r15，mxcsr 与 x87 控制字
+ *   aarch64  x19-x28 x29(fp) x30(lr)，d8-d15
+ *
+ * 不保存信号掩码：协程之间共享线程的信号掩码
+ */
+
+typedef struct coctx_s {
+	void *sp;
+} coctx_t;
+
+typedef void (*coctx_func)(void *arg);
+
+// 保存当前上下文到 from，切到 to
+void coctx_swap(coctx_t *from, coctx_t *to);
+
+// 新上下文的入口；第一次切进去时调用 func(arg)
+void coctx_entry(void);
+
+// 在 [stack, stack + size) 上准备一个首次切入时执行 func(arg) 的上下文
+// func 不能返回，结束时应切回调度器且不再被切入
+static inline void coctx_make(coctx_t *ctx, void *stack, size_t size, coctx_func func, void *arg) {
+	uintptr_t top = ((uintptr_t)stack + size) & ~(uintptr_t)15;
+	void **sp;
+
+#if defined(__x86_64__)
+	// 自顶向下：返回地址 rbp rbx r12 r13 r14 r15 | mxcsr fpucw
+	// ret 之后 rsp 16 字节对齐，coctx_entry 里的 call 满足 ABI
+	sp = (void **)(top - 16);
+	*--sp = (void *)coctx_entry;
+	*--sp = NULL;					// rbp
+	*--sp = NULL;					// rbx
+	*--sp = (void *)func;			// r12
+	*--sp = arg;					// r13
+	*--sp = NULL;					// r14
+	*--sp = NULL;					// r15
+	*--sp = (void *)(uintptr_t)(0x1F80 | (0x037Full << 32));	// 默认 mxcsr / x87 控制字
+#elif defined(__aarch64__)
+	// 与 coctx_swap 的 160 字节帧布局一致：x19 x20 ... x29 x30 d8-d15
+	sp = (void **)(top - 160);
+	int i;
+	for (i = 0; i < 20; i ++) sp[i] = NULL;
+	sp[0] = (void *)func;			// x19
+	sp[1] = arg;					// x20
+	sp[11] = (void *)coctx_entry;	// x30
+#else
+#error "coctx only supports x86-64 and aarch64"
+#endif
+
+	ctx->sp = sp;
+}
+
+#endif
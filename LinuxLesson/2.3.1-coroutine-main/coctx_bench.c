@@ -0,0 +1,105 @@
+
+
+
+// shell: gcc -O2 -o coctx_bench coctx_bench.c coctx_swap.S
+// 主协程与一个协程来回切换，对比 swapcontext 与手写汇编的每秒切换次数
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "coctx.h"
+
+
+#define STACK_SIZE		(64 * 1024)
+#define SWITCHES		10000000
+
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void report(const char *name, uint64_t switches, uint64_t ns) {
+	printf("%-10s switches: %llu  used: %llums  %.1f ns/switch  %.0f switches/s\n",
+		name, (unsigned long long)switches, (unsigned long long)(ns / 1000000),
+		(double)ns / switches, switches * 1e9 / ns);
+}
+
+
+// ucontext
+ucontext_t uc_main, uc_co;
+
+void uc_func(void) {
+	while (1) {
+		swapcontext(&uc_co, &uc_main);
+	}
+}
+
+void bench_ucontext(void) {
+	char *stack = malloc(STACK_SIZE);
+
+	getcontext(&uc_co);
+	uc_co.uc_stack.ss_sp = stack;
+	uc_co.uc_stack.ss_size = STACK_SIZE;
+	uc_co.uc_link = NULL;
+	makecontext(&uc_co, uc_func, 0);
+
+	int i;
+	uint64_t t1 = now_ns();
+	for (i = 0; i < SWITCHES / 2; i ++) {
+		swapcontext(&uc_main, &uc_co);
+	}
+	report("ucontext", SWITCHES, now_ns() - t1);
+
+	free(stack);
+}
+
+
+// coctx
+coctx_t co_main, co_co;
+
+void co_func(void *arg) {
+	uint64_t *count = arg;
+	while (1) {
+		(*count) ++;
+		coctx_swap(&co_co, &co_main);
+	}
+}
+
+void bench_coctx(void) {
+	char *stack = malloc(STACK_SIZE);
+	uint64_t count = 0;
+
+	coctx_make(&co_co, stack, STACK_SIZE, co_func, &count);
+
+	int i;
+	uint64_t t1 = now_ns();
+	for (i = 0; i < SWITCHES / 2; i ++) {
+		coctx_swap(&co_main, &co_co);
+	}
+	uint64_t ns = now_ns() - t1;
+	if (count != SWITCHES / 2) {
+		printf("coctx: MISMATCH %llu\n", (unsigned long long)count);
+	}
+	report("coctx", SWITCHES, ns);
+
+	free(stack);
+}
+
+
+int main() {
+
+	bench_ucontext();
+	bench_coctx();
+
+	return 0;
+}
+
+
+
@@ -0,0 +1,360 @@
+
+
+
+
+// shell: gcc -O2 -o echo_bench echo_bench.c reactor.c -lpthread
+// 配合 server_mulport_epoll 的本地压测：先建立 -c 个长连接（分散到 -n 个端口上），
+// 再让每个连接同时只有一条 -s 字节的消息在途，跑 -d 秒，统计吞吐和往返延迟
+// ./echo_bench -c 1000000 -n 100 -t 4 -b 2 -m 20
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <unistd.h>
+#include <pthread.h>
+
+#include "reactor.h"
+
+
+#define MAX_BENCH_THREAD	64
+#define HIST_BUCKETS		32		// 按 2 的幂分桶，第 i 桶是 [2^(i-1), 2^i) 微秒
+
+
+struct bench_conn {
+	reactor_conn_t *conn;
+	uint64_t sent_us;
+	uint32_t got;
+	int index;
+	int opened;
+};
+
+typedef struct bench_thread {
+	int index;
+	pthread_t thread;
+	reactor_t *reactor;
+
+	int count;				// 负责 index, index + nthreads, ... 号连接
+	int next;				// 下一个要发起的连接
+	int connecting;
+	int running;			// 回显阶段
+	struct bench_conn *conns;
+
+	// 本线程写，主线程原子读
+	uint64_t connected;
+	uint64_t failed;
+	uint64_t closed;
+	uint64_t msgs;
+	uint64_t bytes;
+	uint64_t hist[HIST_BUCKETS];
+} __attribute__((aligned(64))) bench_thread_t;
+
+
+static struct sockaddr_in server_addr;
+static int nports = 100;
+static int nconns = 10000;
+static int msg_size = 64;
+static int duration = 10;
+static int nthreads = 1;
+static int src_base = 0;		// 非 0 时依次 bind 到 127.0.0.src_base 开始的 src_count 个源地址
+static int src_count = 1;
+static int inflight = 256;		// 每个线程同时在进行的 connect 数
+
+static bench_thread_t threads[MAX_BENCH_THREAD];
+static char *payload;
+
+#define STAT_ADD(t, field, n)	__atomic_fetch_add(&(t)->field, (n), __ATOMIC_RELAXED)
+#define STAT_GET(t, field)		__atomic_load_n(&(t)->field, __ATOMIC_RELAXED)
+
+
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void bench_send(struct bench_conn *bc) {
+	bc->sent_us = now_us();
+	reactor_send(bc->conn, payload, msg_size);
+}
+
+static void connect_more(bench_thread_t *t);
+
+static void bench_open(reactor_conn_t *c) {
+	struct bench_conn *bc = c->user;
+	bench_thread_t *t = &threads[bc->index % nthreads];
+
+	bc->opened = 1;
+	t->connecting --;
+	STAT_ADD(t, connected, 1);
+	connect_more(t);
+}
+
+static void bench_read(reactor_conn_t *c) {
+	struct bench_conn *bc = c->user;
+	bench_thread_t *t = &threads[bc->index % nthreads];
+	size_t len = ring_len(&c->rbuf);
+
+	ring_consume(&c->rbuf, len);
+	bc->got += len;
+	if (bc->got < (uint32_t)msg_size) return ;
+	bc->got -= msg_size;
+
+	uint64_t rtt = now_us() - bc->sent_us;
+	int bucket = rtt ? 64 - __builtin_clzll(rtt) : 0;
+	if (bucket >= HIST_BUCKETS) bucket = HIST_BUCKETS - 1;
+	t->hist[bucket] ++;
+	STAT_ADD(t, msgs, 1);
+	STAT_ADD(t, bytes, msg_size);
+
+	if (t->running) bench_send(bc);
+}
+
+static void bench_close(reactor_conn_t *c, int err) {
+	struct bench_conn *bc = c->user;
+	bench_thread_t *t = &threads[bc->index % nthreads];
+
+	bc->conn = NULL;
+	if (bc->opened) {
+		STAT_ADD(t, closed, 1);
+		return ;
+	}
+
+	if (STAT_GET(t, failed) < 5) {
+		printf("connect %d failed: %s\n", bc->index, strerror(err));
+	}
+	t->connecting --;
+	STAT_ADD(t, failed, 1);
+	connect_more(t);
+}
+
+static const struct reactor_handler bench_handler = {
+	.on_open = bench_open,
+	.on_read = bench_read,
+	.on_close = bench_close,
+};
+
+// 连接号 i 由 i % nthreads 号线程负责，目的端口和源地址也按 i 轮转
+static void connect_more(bench_thread_t *t) {
+	while (t->connecting < inflight && t->next < t->count) {
+		struct bench_conn *bc = &t->conns[t->next ++];
+		int i = bc->index;
+
+		struct sockaddr_in addr = server_addr;
+		addr.sin_port = htons(ntohs(server_addr.sin_port) + i % nports);
+
+		struct sockaddr_in local;
+		memset(&local, 0, sizeof(local));
+		local.sin_family = AF_INET;
+		local.sin_addr.s_addr = htonl((127u << 24) | (src_base + i / nports % src_count));
+
+		bc->conn = reactor_connect(t->reactor, (struct sockaddr *)&addr, sizeof(addr),
+			src_base ? (struct sockaddr *)&local : NULL, &bench_handler, bc);
+		if (bc->conn == NULL) {
+			if (STAT_GET(t, failed) < 5) perror("connect");
+			STAT_ADD(t, failed, 1);
+			if (errno == EMFILE || errno == ENFILE) {
+				// fd 用完了，后面的都不用试
+				STAT_ADD(t, failed, t->count - t->next);
+				t->next = t->count;
+			}
+			continue;
+		}
+		t->connecting ++;
+	}
+}
+
+static void bench_start(reactor_t *r, void *arg) {
+	bench_thread_t *t = arg;
+	connect_more(t);
+}
+
+static void echo_start(reactor_t *r, void *arg) {
+	bench_thread_t *t = arg;
+	int i;
+
+	t->running = 1;
+	for (i = 0; i < t->count; i ++) {
+		if (t->conns[i].conn) bench_send(&t->conns[i]);
+	}
+}
+
+static void echo_stop(reactor_t *r, void *arg) {
+	bench_thread_t *t = arg;
+	t->running = 0;
+	reactor_stop(r);
+}
+
+static void *bench_thread(void *arg) {
+	bench_thread_t *t = arg;
+	if (reactor_run(t->reactor) < 0) perror("reactor_run");
+	return NULL;
+}
+
+
+static void sum_stats(uint64_t *connected, uint64_t *failed, uint64_t *closed,
+	uint64_t *msgs, uint64_t *bytes) {
+
+	int i;
+	*connected = *failed = *closed = *msgs = *bytes = 0;
+	for (i = 0; i < nthreads; i ++) {
+		*connected += STAT_GET(&threads[i], connected);
+		*failed += STAT_GET(&threads[i], failed);
+		*closed += STAT_GET(&threads[i], closed);
+		*msgs += STAT_GET(&threads[i], msgs);
+		*bytes += STAT_GET(&threads[i], bytes);
+	}
+}
+
+static uint64_t hist_percentile(const uint64_t *hist, uint64_t total, double p) {
+	uint64_t want = (uint64_t)(total * p), seen = 0;
+	int i;
+	for (i = 0; i < HIST_BUCKETS; i ++) {
+		seen += hist[i];
+		if (seen > want) return 1ull << i;
+	}
+	return 1ull << (HIST_BUCKETS - 1);
+}
+
+static void usage(const char *name) {
+	printf("usage: %s [-a ip] [-p port] [-n ports] [-c conns] [-s size] [-d seconds]\n"
+		"          [-t threads] [-b src_base] [-m src_count] [-k inflight]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+	const char *ip = "127.0.0.1";
+	int port = 8080;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "a:p:n:c:s:d:t:b:m:k:h")) != -1) {
+		switch (opt) {
+			case 'a': ip = optarg; break;
+			case 'p': port = atoi(optarg); break;
+			case 'n': nports = atoi(optarg); break;
+			case 'c': nconns = atoi(optarg); break;
+			case 's': msg_size = atoi(optarg); break;
+			case 'd': duration = atoi(optarg); break;
+			case 't': nthreads = atoi(optarg); break;
+			case 'b': src_base = atoi(optarg); break;
+			case 'm': src_count = atoi(optarg); break;
+			case 'k': inflight = atoi(optarg); break;
+			default: usage(argv[0]); return 1;
+		}
+	}
+	if (nports < 1 || nconns < 1 || msg_size < 1 || nthreads < 1 || nthreads > MAX_BENCH_THREAD ||
+		src_count < 1 || src_base < 0 || src_base + src_count > 255 || inflight < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	memset(&server_addr, 0, sizeof(server_addr));
+	server_addr.sin_family = AF_INET;
+	server_addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, ip, &server_addr.sin_addr) != 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	payload = malloc(msg_size);
+	memset(payload, 'a', msg_size);
+
+	for (i = 0; i < nthreads; i ++) {
+		bench_thread_t *t = &threads[i];
+		t->index = i;
+		t->reactor = reactor_create();
+		t->count = nconns / nthreads + (i < nconns % nthreads);
+		t->conns = calloc(t->count, sizeof(struct bench_conn));
+		if (t->reactor == NULL || t->conns == NULL) {
+			perror("reactor_create");
+			return 1;
+		}
+
+		int j;
+		for (j = 0; j < t->count; j ++) {
+			t->conns[j].index = i + j * nthreads;
+		}
+
+		reactor_post(t->reactor, bench_start, t);
+		pthread_create(&t->thread, NULL, bench_thread, t);
+	}
+
+	// 建连阶段
+	uint64_t connected, failed, closed, msgs, bytes, last = 0;
+	uint64_t t0 = now_us(), idle_since = t0, tick = 0;
+	while (1) {
+		usleep(10 * 1000);
+		sum_stats(&connected, &failed, &closed, &msgs, &bytes);
+		if (connected + failed >= (uint64_t)nconns) break;
+
+		if (connected != last) {
+			idle_since = now_us();
+		} else if (now_us() - idle_since > 10 * 1000 * 1000) {
+			printf("no progress in 10s, giving up on the rest\n");
+			break;
+		}
+		if (++ tick % 100 == 0) {
+			printf("connections: %llu, failed: %llu\n",
+				(unsigned long long)connected, (unsigned long long)failed);
+		}
+		last = connected;
+	}
+	uint64_t connect_us = now_us() - t0;
+	printf("connect phase: %llu connections in %llu ms (%.0f/s), failed: %llu\n",
+		(unsigned long long)connected, (unsigned long long)(connect_us / 1000),
+		connected * 1e6 / connect_us, (unsigned long long)failed);
+
+	// 回显阶段
+	for (i = 0; i < nthreads; i ++) reactor_post(threads[i].reactor, echo_start, &threads[i]);
+
+	uint64_t last_msgs = 0, last_bytes = 0;
+	t0 = now_us();
+	for (i = 0; i < duration; i ++) {
+		usleep(1000 * 1000);
+		sum_stats(&connected, &failed, &closed, &msgs, &bytes);
+		printf("msgs/s: %llu, MB/s: %.2f, closed: %llu\n",
+			(unsigned long long)(msgs - last_msgs),
+			(double)(bytes - last_bytes) / (1024 * 1024), (unsigned long long)closed);
+		last_msgs = msgs;
+		last_bytes = bytes;
+	}
+	uint64_t echo_us = now_us() - t0;
+
+	for (i = 0; i < nthreads; i ++) reactor_post(threads[i].reactor, echo_stop, &threads[i]);
+	for (i = 0; i < nthreads; i ++) pthread_join(threads[i].thread, NULL);
+
+	uint64_t hist[HIST_BUCKETS] = {0};
+	int j;
+	for (i = 0; i < nthreads; i ++) {
+		for (j = 0; j < HIST_BUCKETS; j ++) hist[j] += threads[i].hist[j];
+	}
+	sum_stats(&connected, &failed, &closed, &msgs, &bytes);
+
+	printf("total: %llu msgs in %llu ms, %.0f msgs/s, %.2f MB/s\n",
+		(unsigned long long)msgs, (unsigned long long)(echo_us / 1000),
+		msgs * 1e6 / echo_us, bytes * 1e6 / echo_us / (1024 * 1024));
+	if (msgs > 0) {
+		printf("rtt (us, bucket upper bound): p50 <%llu  p90 <%llu  p99 <%llu  p999 <%llu\n",
+			(unsigned long long)hist_percentile(hist, msgs, 0.50),
+			(unsigned long long)hist_percentile(hist, msgs, 0.90),
+			(unsigned long long)hist_percentile(hist, msgs, 0.99),
+			(unsigned long long)hist_percentile(hist, msgs, 0.999));
+	}
+
+	for (i = 0; i < nthreads; i ++) {
+		// destroy 会关掉还在 connect 的连接，bench_close 里的 connect_more 不能再发起新连接
+		threads[i].next = threads[i].count;
+		reactor_destroy(threads[i].reactor);
+		free(threads[i].conns);
+	}
+	free(payload);
+
+	return 0;
+}
@@ -1,17 +1,25 @@
 
 
 
+// shell: gcc -O2 -o hook hook.c coctx_swap.S -ldl -lpthread
+
 #define _GNU_SOURCE
 
 #include <dlfcn.h>
 
 #include <stdio.h>
-#include <ucontext.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <signal.h>
+#include <time.h>
 
 #include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
 #include <errno.h>
 #include <netinet/in.h>
 
@@ -19,6 +27,142 @@
 #include <pthread.h>
 #include <sys/poll.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "coctx.h"
+
+
+#define CO_STACK_SIZE		(128 * 1024)	// 独立栈大小，另有一页保护页
+#define CO_STACK_POOL_MAX	1024			// 每个调度器缓存的空闲独立栈
+#define CO_SHARED_STACKS	4				// 每个调度器的共享栈个数，协程轮流分配
+#define CO_SHARED_STACK_SIZE	(1024 * 1024)
+#define CO_MAX_EVENTS		1024
+
+#define FD_PAGE_SHIFT		12
+#define FD_PAGE_SIZE		(1 << FD_PAGE_SHIFT)
+#define FD_PAGES			1024		// 最多 4M 个 fd
+
+
+typedef void (*coroutine_func)(void *arg);
+
+/**
+ * 栈模式：
+ *   CO_STACK_POOLED  每个协程一块 mmap 的独立栈，低地址端一页 PROT_NONE 保护页，
+ *                    栈溢出直接段错误而不是踩坏别的内存；协程结束后栈回到调度器的空闲池复用。
+ *                    每块栈占两个 VMA，协程数受 vm.max_map_count 限制（默认约 3 万）
+ *   CO_STACK_SHARED  libaco 式共享栈：协程都在调度器的共享栈上运行，被别的协程占用栈时
+ *                    才把自己活跃的那段栈（sp 到栈顶）拷到私有的保存区；空闲连接只占
+ *                    几百字节的保存区。代价是切换时的拷贝，且挂起期间栈上变量的地址会失效，
+ *                    不能把栈上对象的指针交给别的协程
+ */
+enum co_stack_mode {
+	CO_STACK_POOLED,
+	CO_STACK_SHARED,
+};
+
+struct co_stack {
+	char *base;
+	size_t size;
+	struct coroutine *owner;	// 当前栈上是谁的数据
+};
+
+enum co_status {
+	CO_READY,
+	CO_RUNNING,
+	CO_WAITING,
+	CO_MIGRATING,				// 切出后交给 migrate_to 调度器
+	CO_DEAD,
+};
+
+struct coroutine {
+	coctx_t ctx;
+	void *stack;				// 独立栈
+	struct co_stack *shared;	// 共享栈模式下所用的共享栈
+	char *saved;				// 共享栈模式下被换出时活跃栈的副本
+	size_t saved_size;
+	size_t saved_cap;
+	coroutine_func func;
+	void *arg;
+	enum co_status status;
+
+	struct coroutine *next;		// 就绪队列
+	int wake_local;				// 被 fd 事件唤醒：留在本调度器，不给别人偷
+	struct schedule *migrate_to;
+
+	uint64_t deadline;			// 睡眠/等待超时的到期时间（纳秒）
+	int heap_idx;				// 在定时堆中的下标，-1 表示不在堆中
+	int timedout;
+
+	struct pollfd *waits;		// 正在等待的 fd，指向 wait1 或 waitv
+	nfds_t nwaits;
+	struct pollfd wait1;		// 单个 fd 等待时用这个，免得每次分配
+	struct pollfd *waitv;		// poll 的 fd 数组的副本：共享栈会被换出，不能指向协程栈
+	nfds_t waitv_cap;
+};
+
+// fd 号全进程唯一，表也全进程共享；等待者只在所属调度器线程上读写
+struct fd_ctx {
+	struct coroutine *reader;
+	struct coroutine *writer;
+	uint32_t armed;				// 当前注册到 epoll 的事件，0 表示未注册
+	struct schedule *owner;		// 第一次等待它的调度器，之后等它的协程都迁移过去
+	int managed;				// socket/accept 钩子创建，底层已设为非阻塞
+	int user_nonblock;			// 用户自己要求非阻塞：EAGAIN 原样返回
+};
+
+struct co_queue {
+	struct coroutine *head;
+	struct coroutine *tail;
+	int len;
+};
+
+// 每个线程一个调度器
+struct schedule {
+	coctx_t ctx;
+	int index;
+	int epfd;
+	int evfd;					// 空闲时被别的调度器叫醒用
+	int idle;					// 正在或即将阻塞在 epoll_wait
+	struct coroutine *current;
+
+	struct co_queue local;		// 只有本线程访问：fd 事件唤醒的、共享栈上的协程
+	struct co_queue runq;		// 可被窃取：新建、yield、睡眠到期的协程
+	pthread_mutex_t runq_lock;
+	int runq_len;				// 锁外窥视用
+	struct co_queue inbox;		// 其他调度器迁移过来的协程
+	pthread_mutex_t inbox_lock;
+	int inbox_len;
+
+	struct coroutine **timers;	// 按 deadline 排序的最小堆
+	int timer_count;
+	int timer_cap;
+
+	enum co_stack_mode stack_mode;
+	void *stack_pool[CO_STACK_POOL_MAX];
+	int stack_pool_count;
+	struct co_stack shared[CO_SHARED_STACKS];
+	int shared_next;
+
+	struct epoll_event events[CO_MAX_EVENTS];
+};
+
+static __thread struct schedule *sched = NULL;
+
+#define CO_MAX_SCHEDULES	256
+
+static struct schedule *schedules[CO_MAX_SCHEDULES];
+static int schedule_count = 0;
+static int idle_count = 0;		// 处于空闲的调度器个数
+static int co_live = 0;			// 全进程存活的协程数
+
+// 协程可能被偷到别的线程继续运行，切换之后必须重新读线程局部变量；
+// 走一个不内联的函数，防止编译器把切换前算好的 TLS 地址沿用到切换之后
+__attribute__((noinline)) static struct schedule *schedule_self(void) {
+	__asm__ volatile("" ::: "memory");
+	return sched;
+}
+
+static struct fd_ctx *fd_pages[FD_PAGES];
 
 
 #if 1
@@ -29,68 +173,1078 @@ read_t read_f = NULL;
 typedef ssize_t (*write_t)(int fd, const void *buf, size_t count);
 write_t write_f = NULL;
 
+typedef ssize_t (*recv_t)(int fd, void *buf, size_t len, int flags);
+recv_t recv_f = NULL;
 
+typedef ssize_t (*send_t)(int fd, const void *buf, size_t len, int flags);
+send_t send_f = NULL;
 
-ssize_t read(int fd, void *buf, size_t count) {
+typedef int (*socket_t)(int domain, int type, int protocol);
+socket_t socket_f = NULL;
+
+typedef int (*accept_t)(int fd, struct sockaddr *addr, socklen_t *addrlen);
+accept_t accept_f = NULL;
+
+typedef int (*connect_t)(int fd, const struct sockaddr *addr, socklen_t addrlen);
+connect_t connect_f = NULL;
+
+typedef int (*close_t)(int fd);
+close_t close_f = NULL;
+
+typedef int (*fcntl_t)(int fd, int cmd, ...);
+fcntl_t fcntl_f = NULL;
+
+typedef int (*poll_t)(struct pollfd *fds, nfds_t nfds, int timeout);
+poll_t poll_f = NULL;
+
+typedef unsigned int (*sleep_t)(unsigned int seconds);
+sleep_t sleep_f = NULL;
+
+typedef int (*usleep_t)(useconds_t usec);
+usleep_t usleep_f = NULL;
+
+
+void init_hook(void) {
+
+	if (!read_f) {
+		read_f = dlsym(RTLD_NEXT, "read");
+	}
+
+	if (!write_f) {
+		write_f = dlsym(RTLD_NEXT, "write");
+	}
+
+	recv_f = dlsym(RTLD_NEXT, "recv");
+	send_f = dlsym(RTLD_NEXT, "send");
+	socket_f = dlsym(RTLD_NEXT, "socket");
+	accept_f = dlsym(RTLD_NEXT, "accept");
+	connect_f = dlsym(RTLD_NEXT, "connect");
+	close_f = dlsym(RTLD_NEXT, "close");
+	fcntl_f = dlsym(RTLD_NEXT, "fcntl");
+	poll_f = dlsym(RTLD_NEXT, "poll");
+	sleep_f = dlsym(RTLD_NEXT, "sleep");
+	usleep_f = dlsym(RTLD_NEXT, "usleep");
+}
+
+// libc 在 main 之前也可能调到这些函数
+#define HOOK_SYS(name)		do { if (!name##_f) init_hook(); } while (0)
+
+#endif
+
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+
+// ---------------- fd 表 ----------------
+
+static struct fd_ctx *fd_lookup(int fd) {
+	if (fd < 0 || (fd >> FD_PAGE_SHIFT) >= FD_PAGES) return NULL;
+	struct fd_ctx *page = __atomic_load_n(&fd_pages[fd >> FD_PAGE_SHIFT], __ATOMIC_ACQUIRE);
+	return page ? &page[fd & (FD_PAGE_SIZE - 1)] : NULL;
+}
+
+// 按页分配，多个线程同时补同一页时 CAS 失败的一方释放自己的
+static struct fd_ctx *fd_get(int fd) {
+	struct fd_ctx *ctx = fd_lookup(fd);
+	if (ctx || fd < 0 || (fd >> FD_PAGE_SHIFT) >= FD_PAGES) return ctx;
+
+	struct fd_ctx *page = calloc(FD_PAGE_SIZE, sizeof(struct fd_ctx));
+	if (!page) return NULL;
+	struct fd_ctx *expected = NULL;
+	if (!__atomic_compare_exchange_n(&fd_pages[fd >> FD_PAGE_SHIFT], &expected, page,
+			0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		free(page);
+		page = expected;
+	}
+	return &page[fd & (FD_PAGE_SIZE - 1)];
+}
+
+// 接管 socket：底层设为非阻塞，对用户仍表现为阻塞（除非用户自己要求非阻塞）
+static void fd_manage(int fd, int user_nonblock) {
+	struct fd_ctx *ctx = fd_get(fd);
+	if (!ctx) return ;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->managed = 1;
+	ctx->user_nonblock = user_nonblock;
+
+	int flags = fcntl_f(fd, F_GETFL, 0);
+	fcntl_f(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// 把 epoll 注册改成 want；失败（如普通文件不支持 epoll）返回 -1
+static int fd_set_events(int fd, struct fd_ctx *ctx, uint32_t want) {
+	if (want == ctx->armed) return 0;
+
+	struct epoll_event ev;
+	ev.events = want;
+	ev.data.fd = fd;
+
+	int op = !ctx->armed ? EPOLL_CTL_ADD : (want ? EPOLL_CTL_MOD : EPOLL_CTL_DEL);
+	if (op == EPOLL_CTL_DEL) ev.events = 0;
+	if (epoll_ctl(sched->epfd, op, fd, &ev) < 0) {
+		// fd 被关掉重开过，旧注册已随关闭失效
+		if (op == EPOLL_CTL_MOD && errno == ENOENT) {
+			op = EPOLL_CTL_ADD;
+			if (epoll_ctl(sched->epfd, op, fd, &ev) == 0) goto armed;
+		}
+		return -1;
+	}
+armed:
+	ctx->armed = want;
+	ctx->owner = sched;
+	return 0;
+}
+
+// 等待前补上等待者关心的事件。已注册但暂时没人等的事件不撤：
+// 被唤醒的协程多半马上又等同一个事件，撤了再加每条消息都要两次 epoll_ctl
+static int fd_arm(int fd, struct fd_ctx *ctx) {
+	uint32_t want = (ctx->reader ? EPOLLIN : 0) | (ctx->writer ? EPOLLOUT : 0);
+	return fd_set_events(fd, ctx, ctx->armed | want);
+}
+
+
+// ---------------- 定时堆 ----------------
+
+static void timer_swap(struct coroutine **timers, int i, int j) {
+	struct coroutine *co = timers[i];
+	timers[i] = timers[j];
+	timers[j] = co;
+	timers[i]->heap_idx = i;
+	timers[j]->heap_idx = j;
+}
+
+static void timer_sift(int i) {
+	struct coroutine **timers = sched->timers;
+	int n = sched->timer_count;
+
+	while (i > 0 && timers[(i - 1) / 2]->deadline > timers[i]->deadline) {
+		timer_swap(timers, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+	while (1) {
+		int l = 2 * i + 1, r = l + 1, min = i;
+		if (l < n && timers[l]->deadline < timers[min]->deadline) min = l;
+		if (r < n && timers[r]->deadline < timers[min]->deadline) min = r;
+		if (min == i) break;
+		timer_swap(timers, i, min);
+		i = min;
+	}
+}
+
+static int timer_add(struct coroutine *co, uint64_t deadline) {
+	if (sched->timer_count == sched->timer_cap) {
+		int cap = sched->timer_cap ? sched->timer_cap * 2 : 64;
+		struct coroutine **timers = realloc(sched->timers, sizeof(*timers) * cap);
+		if (!timers) return -1;
+		sched->timers = timers;
+		sched->timer_cap = cap;
+	}
+	co->deadline = deadline;
+	co->heap_idx = sched->timer_count++;
+	sched->timers[co->heap_idx] = co;
+	timer_sift(co->heap_idx);
+	return 0;
+}
+
+static void timer_del(struct coroutine *co) {
+	int i = co->heap_idx;
+	if (i < 0) return ;
+
+	co->heap_idx = -1;
+	int last = --sched->timer_count;
+	if (i != last) {
+		sched->timers[i] = sched->timers[last];
+		sched->timers[i]->heap_idx = i;
+		timer_sift(i);
+	}
+}
+
+
+// ---------------- 调度器 ----------------
+
+static struct schedule *schedule_get(void) {
+	if (sched) return sched;
+
+	struct schedule *s = calloc(1, sizeof(struct schedule));
+	if (!s) return NULL;
+	s->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (s->epfd >= 0) {
+		s->evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (s->evfd >= 0) {
+			struct epoll_event ev;
+			ev.events = EPOLLIN;
+			ev.data.fd = s->evfd;
+			if (epoll_ctl(s->epfd, EPOLL_CTL_ADD, s->evfd, &ev) == 0) {
+				pthread_mutex_init(&s->runq_lock, NULL);
+				pthread_mutex_init(&s->inbox_lock, NULL);
+				sched = s;
+				return s;
+			}
+			close_f(s->evfd);
+		}
+		close_f(s->epfd);
+	}
+	free(s);
+	return NULL;
+}
+
+// ---------------- 协程栈 ----------------
+
+static size_t page_size(void) {
+	static size_t size = 0;
+	if (!size) size = (size_t)sysconf(_SC_PAGESIZE);
+	return size;
+}
+
+// 返回可用区的低地址，下面紧挨着一页保护页
+static void *stack_map(size_t size) {
+	size_t guard = page_size();
+	char *p = mmap(NULL, size + guard, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+	if (p == MAP_FAILED) return NULL;
+	if (mprotect(p, guard, PROT_NONE) < 0) {
+		munmap(p, size + guard);
+		return NULL;
+	}
+	return p + guard;
+}
+
+static void stack_unmap(void *stack, size_t size) {
+	size_t guard = page_size();
+	munmap((char *)stack - guard, size + guard);
+}
+
+// 空闲池里的栈刚被用过，页已经在内存里，复用不缺页
+static void *stack_get(void) {
+	if (sched->stack_pool_count > 0) {
+		return sched->stack_pool[--sched->stack_pool_count];
+	}
+	return stack_map(CO_STACK_SIZE);
+}
+
+static void stack_put(void *stack) {
+	if (sched->stack_pool_count < CO_STACK_POOL_MAX) {
+		sched->stack_pool[sched->stack_pool_count++] = stack;
+	} else {
+		stack_unmap(stack, CO_STACK_SIZE);
+	}
+}
+
+static struct co_stack *shared_stack_get(void) {
+	struct co_stack *st = &sched->shared[sched->shared_next];
+	if (!st->base) {
+		st->base = stack_map(CO_SHARED_STACK_SIZE);
+		if (!st->base) return NULL;
+		st->size = CO_SHARED_STACK_SIZE;
+	}
+	sched->shared_next = (sched->shared_next + 1) % CO_SHARED_STACKS;
+	return st;
+}
+
+// 把协程在共享栈上的活跃部分 [sp, 栈顶) 拷到保存区
+static int shared_stack_save(struct coroutine *co) {
+	char *top = co->shared->base + co->shared->size;
+	size_t live = top - (char *)co->ctx.sp;
+	if (live > co->saved_cap) {
+		char *saved = realloc(co->saved, live);
+		if (!saved) return -1;
+		co->saved = saved;
+		co->saved_cap = live;
+	}
+	memcpy(co->saved, co->ctx.sp, live);
+	co->saved_size = live;
+	return 0;
+}
+
+// 切入前在调度器自己的栈上执行：先换出当前占用者，再换入自己
+static int shared_stack_enter(struct coroutine *co) {
+	struct co_stack *st = co->shared;
+	if (st->owner == co) return 0;
+	if (st->owner && shared_stack_save(st->owner) < 0) return -1;
+	memcpy(st->base + st->size - co->saved_size, co->saved, co->saved_size);
+	st->owner = co;
+	return 0;
+}
+
+static void coroutine_entry(void *arg);
+
+// 初始帧不含栈地址，先在临时缓冲里构造好当作保存区，第一次切入时再拷到共享栈上
+static int shared_stack_init(struct coroutine *co) {
+	char frame[512] __attribute__((aligned(16)));
+	coctx_t tmp;
+
+	co->shared = shared_stack_get();
+	if (!co->shared) return -1;
+	coctx_make(&tmp, frame, sizeof(frame), coroutine_entry, co);
+
+	size_t live = frame + sizeof(frame) - (char *)tmp.sp;
+	co->saved = malloc(live);
+	if (!co->saved) return -1;
+	memcpy(co->saved, tmp.sp, live);
+	co->saved_size = co->saved_cap = live;
+	co->ctx.sp = co->shared->base + co->shared->size - live;
+	return 0;
+}
+
+// 新建协程前设置，默认 CO_STACK_POOLED
+int schedule_set_stack_mode(enum co_stack_mode mode) {
+	if (!schedule_get()) return -1;
+	sched->stack_mode = mode;
+	return 0;
+}
+
+
+static void queue_push(struct co_queue *q, struct coroutine *co) {
+	co->next = NULL;
+	if (q->tail) {
+		q->tail->next = co;
+	} else {
+		q->head = co;
+	}
+	q->tail = co;
+	q->len ++;
+}
+
+static struct coroutine *queue_pop(struct co_queue *q) {
+	struct coroutine *co = q->head;
+	if (co) {
+		q->head = co->next;
+		if (!q->head) q->tail = NULL;
+		q->len --;
+	}
+	return co;
+}
+
+// 从 from 队头摘下 n 个接到 to 队尾
+static void queue_move(struct co_queue *to, struct co_queue *from, int n) {
+	while (n-- > 0) {
+		struct coroutine *co = queue_pop(from);
+		if (!co) break;
+		queue_push(to, co);
+	}
+}
+
+// 把 s 从 epoll_wait 里叫醒；只有真正进入空闲的调度器才需要写 eventfd
+static void schedule_notify(struct schedule *s) {
+	if (__atomic_exchange_n(&s->idle, 0, __ATOMIC_SEQ_CST)) {
+		uint64_t one = 1;
+		write_f(s->evfd, &one, sizeof(one));
+	}
+}
+
+// 本调度器有多余的可窃取协程时叫醒一个空闲调度器来偷
+static void schedule_wake_idle(void) {
+	if (__atomic_load_n(&idle_count, __ATOMIC_SEQ_CST) == 0) return ;
+
+	int i, n = __atomic_load_n(&schedule_count, __ATOMIC_ACQUIRE);
+	for (i = 0; i < n; i ++) {
+		struct schedule *s = __atomic_load_n(&schedules[i], __ATOMIC_ACQUIRE);
+		if (s && s != sched && __atomic_load_n(&s->idle, __ATOMIC_SEQ_CST)) {
+			schedule_notify(s);
+			return ;
+		}
+	}
+}
+
+// 入队：被 fd 事件唤醒的（local）和共享栈上的协程只进本调度器私有队列，
+// 其余（新建、yield、睡眠到期）进可窃取的 runq
+static void ready_enqueue(struct coroutine *co) {
+	if (co->wake_local || co->shared) {
+		queue_push(&sched->local, co);
+		return ;
+	}
+	pthread_mutex_lock(&sched->runq_lock);
+	queue_push(&sched->runq, co);
+	int len = sched->runq.len;
+	__atomic_store_n(&sched->runq_len, len, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&sched->runq_lock);
+	if (len > 1) schedule_wake_idle();
+}
+
+// 正在运行的协程要等切出、上下文保存好之后才能入队（由 schedule_resume 完成），
+// 否则多线程下可能在保存前就被别的调度器偷走运行
+static void ready_push(struct coroutine *co, int local) {
+	co->status = CO_READY;
+	co->wake_local = local;
+	if (co != sched->current) ready_enqueue(co);
+}
+
+// 迁移到 fd 的所属调度器：放进对方的 inbox，对方下一轮取出运行
+static void inbox_push(struct schedule *s, struct coroutine *co) {
+	pthread_mutex_lock(&s->inbox_lock);
+	queue_push(&s->inbox, co);
+	__atomic_store_n(&s->inbox_len, s->inbox.len, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&s->inbox_lock);
+	schedule_notify(s);
+}
+
+static void inbox_drain(void) {
+	if (__atomic_load_n(&sched->inbox_len, __ATOMIC_SEQ_CST) == 0) return ;
+
+	pthread_mutex_lock(&sched->inbox_lock);
+	queue_move(&sched->local, &sched->inbox, sched->inbox.len);
+	__atomic_store_n(&sched->inbox_len, 0, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&sched->inbox_lock);
+}
+
+// 从其他调度器的 runq 偷一半
+static int schedule_steal(void) {
+	int i, n = __atomic_load_n(&schedule_count, __ATOMIC_ACQUIRE);
+	for (i = 1; i < n; i ++) {
+		struct schedule *victim = __atomic_load_n(&schedules[(sched->index + i) % n], __ATOMIC_ACQUIRE);
+		if (!victim || victim == sched ||
+			__atomic_load_n(&victim->runq_len, __ATOMIC_SEQ_CST) == 0) continue;
+
+		struct co_queue stolen = {0};
+		pthread_mutex_lock(&victim->runq_lock);
+		queue_move(&stolen, &victim->runq, (victim->runq.len + 1) / 2);
+		__atomic_store_n(&victim->runq_len, victim->runq.len, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&victim->runq_lock);
+
+		if (stolen.len > 0) {
+			pthread_mutex_lock(&sched->runq_lock);
+			queue_move(&sched->runq, &stolen, stolen.len);
+			__atomic_store_n(&sched->runq_len, sched->runq.len, __ATOMIC_SEQ_CST);
+			pthread_mutex_unlock(&sched->runq_lock);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// 协程入口；执行完切回调度器，由调度器回收，不会再切回来
+// 协程可能已被偷到别的线程，切回时重新取本线程的调度器
+static void coroutine_entry(void *arg) {
+	struct coroutine *co = arg;
+	co->func(co->arg);
+	co->status = CO_DEAD;
+	coctx_swap(&co->ctx, &schedule_self()->ctx);
+}
+
+int coroutine_create(coroutine_func func, void *arg) {
+	if (!schedule_get()) return -1;
+
+	struct coroutine *co = calloc(1, sizeof(struct coroutine));
+	if (!co) return -1;
+	co->func = func;
+	co->arg = arg;
+	co->heap_idx = -1;
+
+	if (sched->stack_mode == CO_STACK_SHARED) {
+		if (shared_stack_init(co) < 0) {
+			free(co->saved);
+			free(co);
+			return -1;
+		}
+	} else {
+		co->stack = stack_get();
+		if (!co->stack) {
+			free(co);
+			return -1;
+		}
+		coctx_make(&co->ctx, co->stack, CO_STACK_SIZE, coroutine_entry, co);
+	}
+
+	__atomic_add_fetch(&co_live, 1, __ATOMIC_SEQ_CST);
+	ready_push(co, 0);
+	return 0;
+}
+
+// 最后一个协程结束时叫醒所有调度器退出
+static void coroutine_free(struct coroutine *co) {
+	if (co->shared) {
+		if (co->shared->owner == co) co->shared->owner = NULL;
+		free(co->saved);
+	} else {
+		stack_put(co->stack);
+	}
+	free(co->waitv);
+	free(co);
+
+	if (__atomic_sub_fetch(&co_live, 1, __ATOMIC_SEQ_CST) == 0) {
+		int i, n = __atomic_load_n(&schedule_count, __ATOMIC_ACQUIRE);
+		for (i = 0; i < n; i ++) {
+			struct schedule *s = __atomic_load_n(&schedules[i], __ATOMIC_ACQUIRE);
+			if (s && s != sched) schedule_notify(s);
+		}
+	}
+}
+
+// 切回调度器；调用前由调用方决定自己挂在哪里（就绪队列/fd/定时堆/迁移）
+static void coroutine_park(void) {
+	struct schedule *s = schedule_self();
+	coctx_swap(&s->current->ctx, &s->ctx);
+}
+
+void coroutine_yield(void) {
+	ready_push(sched->current, 0);
+	coroutine_park();
+}
+
+// 迁移到 fd 所属的调度器；返回时已在对方线程上运行
+static void coroutine_migrate(struct schedule *to) {
+	struct coroutine *co = sched->current;
+	co->status = CO_MIGRATING;
+	co->migrate_to = to;
+	coroutine_park();
+}
+
+// 从所有等待点摘下并放回就绪队列；fd 的 epoll 注册留到下一次事件再撤，
+// 协程接着等同一个 fd 时（echo 的 read 循环）就不用反复 epoll_ctl
+static void coroutine_wake(struct coroutine *co, int timedout, int local) {
+	nfds_t i;
+	for (i = 0; i < co->nwaits; i ++) {
+		struct fd_ctx *ctx = fd_lookup(co->waits[i].fd);
+		if (!ctx) continue;
+		if (ctx->reader == co) ctx->reader = NULL;
+		if (ctx->writer == co) ctx->writer = NULL;
+	}
+	co->nwaits = 0;
+	timer_del(co);
+	co->timedout = timedout;
+	ready_push(co, local);
+}
+
+// 等待的 fd 都属于同一个其他调度器时返回它；没有归属或属于本调度器返回 NULL，
+// 分属多个调度器时返回 (void *)-1
+static struct schedule *fd_home(struct pollfd *fds, nfds_t nfds) {
+	struct schedule *home = NULL;
+	nfds_t i;
+	for (i = 0; i < nfds; i ++) {
+		struct fd_ctx *ctx = fd_lookup(fds[i].fd);
+		if (!ctx || !ctx->owner) continue;
+		if (home && ctx->owner != home) return (struct schedule *)-1;
+		home = ctx->owner;
+	}
+	return home == sched ? NULL : home;
+}
+
+// 挂起当前协程直到 fds 中任意一个就绪或超时（timeout_ms < 0 不超时）
+// 返回 1 表示有事件，0 表示超时，-1 表示出错（errno）
+// fd 的等待者只由注册它的调度器读写：fd 属于别的调度器时先迁移过去再等
+static int coroutine_wait(struct pollfd *fds, nfds_t nfds, int timeout_ms) {
+	struct coroutine *co = sched->current;
+	struct schedule *home;
+	int immediate = 0;
+	nfds_t i;
+
+	while ((home = fd_home(fds, nfds)) != NULL) {
+		if (home == (struct schedule *)-1 || co->shared) {
+			// 无法迁移（fd 分属多个调度器，或协程在本调度器的共享栈上），归属也不会自己变：
+			// 退化为阻塞 poll，会卡住本调度器，但不会空转
+			int ret = poll_f(fds, nfds, timeout_ms);
+			return ret < 0 ? -1 : ret > 0;
+		}
+		coroutine_migrate(home);
+	}
+
+	if (fds != &co->wait1) {
+		if (nfds > co->waitv_cap) {
+			struct pollfd *waitv = realloc(co->waitv, sizeof(*waitv) * nfds);
+			if (!waitv) {
+				errno = ENOMEM;
+				return -1;
+			}
+			co->waitv = waitv;
+			co->waitv_cap = nfds;
+		}
+		memcpy(co->waitv, fds, sizeof(*fds) * nfds);
+		fds = co->waitv;
+	}
+	co->waits = fds;
+	co->nwaits = nfds;
+	for (i = 0; i < nfds; i ++) {
+		struct fd_ctx *ctx = fd_get(fds[i].fd);
+		if (!ctx) {
+			immediate = 1;
+			continue;
+		}
+		if (fds[i].events & POLLIN) ctx->reader = co;
+		if (fds[i].events & POLLOUT) ctx->writer = co;
+		if (fd_arm(fds[i].fd, ctx) < 0) immediate = 1;
+	}
+
+	if (immediate) {
+		// 有 fd 无法用 epoll 等待（普通文件总是就绪），交给调用方直接重试
+		coroutine_wake(co, 0, 1);
+	} else if (timeout_ms >= 0) {
+		timer_add(co, now_ns() + (uint64_t)timeout_ms * 1000000ull);
+	}
+	if (co->status != CO_READY) co->status = CO_WAITING;
+	coroutine_park();
+	return co->timedout ? 0 : 1;
+}
+
+static void coroutine_sleep_ns(uint64_t ns) {
+	struct coroutine *co = sched->current;
+	co->status = CO_WAITING;
+	timer_add(co, now_ns() + ns);
+	coroutine_park();
+}
+
+static void schedule_resume(struct coroutine *co) {
+	if (co->shared && shared_stack_enter(co) < 0) {
+		// 保存区分配失败：这一轮先不切入，留在就绪队列重试
+		queue_push(&sched->local, co);
+		return ;
+	}
+	sched->current = co;
+	co->status = CO_RUNNING;
+	coctx_swap(&sched->ctx, &co->ctx);
+	sched->current = NULL;
+
+	switch (co->status) {
+	case CO_DEAD:
+		coroutine_free(co);
+		break;
+	case CO_READY:
+		ready_enqueue(co);
+		break;
+	case CO_MIGRATING:
+		inbox_push(co->migrate_to, co);
+		break;
+	default:	// 挂在 fd 或定时堆上
+		break;
+	}
+}
+
+static void schedule_dispatch(int nready) {
+	int i;
+	for (i = 0; i < nready; i ++) {
+		int fd = sched->events[i].data.fd;
+		uint32_t events = sched->events[i].events;
+		if (fd == sched->evfd) {
+			uint64_t count;
+			read_f(fd, &count, sizeof(count));
+			continue;
+		}
+		struct fd_ctx *ctx = fd_lookup(fd);
+		if (!ctx) continue;
+
+		uint32_t idle = 0;		// 报上来却没人等的事件
+		if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+			if (ctx->reader) coroutine_wake(ctx->reader, 0, 1);
+			else idle |= EPOLLIN;
+		}
+		if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+			if (ctx->writer) coroutine_wake(ctx->writer, 0, 1);
+			else idle |= EPOLLOUT;
+		}
+		// 只撤没人等的事件，否则水平触发会一直报；刚唤醒的等待者的注册留给它下次等待
+		if (ctx->armed & idle) fd_set_events(fd, ctx, ctx->armed & ~idle);
+	}
+
+	uint64_t now = now_ns();
+	while (sched->timer_count > 0 && sched->timers[0]->deadline <= now) {
+		coroutine_wake(sched->timers[0], 1, 0);
+	}
+}
+
+static int schedule_has_work(void) {
+	return sched->local.len > 0 ||
+		__atomic_load_n(&sched->runq_len, __ATOMIC_SEQ_CST) > 0 ||
+		__atomic_load_n(&sched->inbox_len, __ATOMIC_SEQ_CST) > 0;
+}
+
+// 调度循环：私有队列 -> 自己的 runq -> 事件/定时器；没事可做时先偷再休眠
+static void schedule_loop(void) {
+	while (__atomic_load_n(&co_live, __ATOMIC_SEQ_CST) > 0) {
+		inbox_drain();
 
-	struct pollfd fds[1] = {0};
+		// 只跑本轮开始时已就绪的协程，yield 的协程下一轮再跑，不饿死 I/O
+		struct co_queue batch = {0};
+		queue_move(&batch, &sched->local, sched->local.len);
+		if (__atomic_load_n(&sched->runq_len, __ATOMIC_SEQ_CST) > 0) {
+			pthread_mutex_lock(&sched->runq_lock);
+			queue_move(&batch, &sched->runq, sched->runq.len);
+			__atomic_store_n(&sched->runq_len, 0, __ATOMIC_SEQ_CST);
+			pthread_mutex_unlock(&sched->runq_lock);
+		}
+		struct coroutine *co;
+		while ((co = queue_pop(&batch)) != NULL) {
+			schedule_resume(co);
+		}
+
+		int timeout = -1;
+		if (schedule_has_work()) {
+			timeout = 0;
+		} else if (schedule_steal()) {
+			timeout = 0;
+		} else if (sched->timer_count > 0) {
+			uint64_t now = now_ns(), deadline = sched->timers[0]->deadline;
+			timeout = deadline > now ? (int)((deadline - now + 999999) / 1000000) : 0;
+		}
+
+		// 复查时 timeout 可能被改成 0，撤销空闲标记只看是否宣布过
+		int announced = 0;
+		if (timeout != 0) {
+			// 先宣布空闲再复查一遍，和入队方的“先入队再看空闲标记”配对，不丢唤醒
+			__atomic_store_n(&sched->idle, 1, __ATOMIC_SEQ_CST);
+			__atomic_add_fetch(&idle_count, 1, __ATOMIC_SEQ_CST);
+			announced = 1;
+			if (schedule_has_work() || __atomic_load_n(&co_live, __ATOMIC_SEQ_CST) == 0) {
+				timeout = 0;
+			}
+		}
+
+		int nready = epoll_wait(sched->epfd, sched->events, CO_MAX_EVENTS, timeout);
+
+		if (announced) {
+			__atomic_store_n(&sched->idle, 0, __ATOMIC_SEQ_CST);
+			__atomic_sub_fetch(&idle_count, 1, __ATOMIC_SEQ_CST);
+		}
+		if (nready < 0 && errno != EINTR) {
+			perror("epoll_wait");
+			break;
+		}
+		schedule_dispatch(nready > 0 ? nready : 0);
+	}
+}
+
+// 单线程运行到所有协程结束
+void schedule_run(void) {
+	if (!schedule_get()) return ;
+	schedule_loop();
+}
+
+
+struct schedule_thread_arg {
+	int index;
+	void (*init)(int index, void *arg);
+	void *arg;
+	pthread_barrier_t *barrier;
+};
+
+static void *schedule_thread(void *p) {
+	struct schedule_thread_arg *targ = p;
+
+	// 每个调度器绑一个核
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu > 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(targ->index % ncpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+
+	struct schedule *s = schedule_get();
+	if (s) {
+		s->index = targ->index;
+		__atomic_store_n(&schedules[targ->index], s, __ATOMIC_RELEASE);
+	}
+	// 等所有调度器都登记好、各自的初始协程都建好再开始调度，避免刚启动就以为没有协程而退出
+	if (s && targ->init) targ->init(targ->index, targ->arg);
+	pthread_barrier_wait(targ->barrier);
+
+	if (s) schedule_loop();
+	return NULL;
+}
+
+/**
+ * M:N 运行：nthreads 个调度器线程（调用线程是 0 号），每个一个 epoll 和一组运行队列。
+ * 每个调度器先在自己线程上调用 init(index, arg) 创建初始协程（例如各自的 SO_REUSEPORT 监听）；
+ * 空闲调度器从别人的 runq 偷协程，等 fd 的协程留在注册该 fd 的调度器上。
+ * 所有协程结束后返回
+ */
+int schedule_run_mt(int nthreads, void (*init)(int index, void *arg), void *arg) {
+	if (nthreads < 1 || nthreads > CO_MAX_SCHEDULES) return -1;
 
-	fds[0].fd = fd;
-	fds[0].events = POLLIN;
+	pthread_t tids[CO_MAX_SCHEDULES];
+	struct schedule_thread_arg targs[CO_MAX_SCHEDULES];
+	pthread_barrier_t barrier;
+	int i;
 
-	int res = poll(fds, 1, 0);
-	if (res <= 0) { //
+	pthread_barrier_init(&barrier, NULL, nthreads);
+	__atomic_store_n(&schedule_count, nthreads, __ATOMIC_RELEASE);
+	for (i = 0; i < nthreads; i ++) {
+		targs[i].index = i;
+		targs[i].init = init;
+		targs[i].arg = arg;
+		targs[i].barrier = &barrier;
+	}
+	for (i = 1; i < nthreads; i ++) {
+		if (pthread_create(&tids[i], NULL, schedule_thread, &targs[i]) != 0) {
+			perror("pthread_create");
+			exit(1);
+		}
+	}
+	schedule_thread(&targs[0]);
+	for (i = 1; i < nthreads; i ++) {
+		pthread_join(tids[i], NULL);
+	}
+	pthread_barrier_destroy(&barrier);
+	return 0;
+}
 
 
-		// fd --> epoll_ctl();
+// ---------------- 钩子 ----------------
 
-		swapcontext(); // fd --> ctx
-		
+// 在协程里挂起等待；不在协程里（如 main 直接调用）退化为阻塞 poll
+static int fd_wait(int fd, short events) {
+	if (sched && sched->current) {
+		struct coroutine *co = sched->current;
+		co->wait1.fd = fd;
+		co->wait1.events = events;
+		co->wait1.revents = 0;
+		return coroutine_wait(&co->wait1, 1, -1) < 0 ? -1 : 0;
 	}
-	// io
+	struct pollfd pfd = { .fd = fd, .events = events };
+	return poll_f(&pfd, 1, -1) < 0 ? -1 : 0;
+}
+
+static struct fd_ctx *fd_blocking(int fd) {
+	struct fd_ctx *ctx = fd_lookup(fd);
+	return ctx && ctx->managed && !ctx->user_nonblock ? ctx : NULL;
+}
+
+// 被接管的阻塞 fd：EAGAIN 时挂起等待，就绪后重试
+#define HOOK_IO(fd, events, call) do {								\
+	ssize_t ret_;												\
+	if (!fd_blocking(fd)) return call;							\
+	while ((ret_ = (call)) < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {	\
+		if (fd_wait(fd, events) < 0) return -1;					\
+	}															\
+	return ret_;												\
+} while (0)
 
-	
-	ssize_t ret = read_f(fd, buf, count);
-	printf("read: %s\n", (char *)buf);
-	return ret;
 
-	
-	
+ssize_t read(int fd, void *buf, size_t count) {
+	HOOK_SYS(read);
+	HOOK_IO(fd, POLLIN, read_f(fd, buf, count));
 }
 
 
 ssize_t write(int fd, const void *buf, size_t count) {
+	HOOK_SYS(write);
+	// 接管的 fd 都是 socket：和 send 钩子一样带上 MSG_NOSIGNAL，对端重置时返回 EPIPE 而不是被 SIGPIPE 杀掉
+	struct fd_ctx *ctx = fd_lookup(fd);
+	if (ctx && ctx->managed) HOOK_IO(fd, POLLOUT, send_f(fd, buf, count, MSG_NOSIGNAL));
+	HOOK_IO(fd, POLLOUT, write_f(fd, buf, count));
+}
 
-	printf("write: %s\n", (const char *)buf);
 
-	return write_f(fd, buf, count);
+ssize_t recv(int fd, void *buf, size_t len, int flags) {
+	HOOK_SYS(recv);
+	HOOK_IO(fd, POLLIN, recv_f(fd, buf, len, flags));
 }
 
 
+ssize_t send(int fd, const void *buf, size_t len, int flags) {
+	HOOK_SYS(send);
+	HOOK_IO(fd, POLLOUT, send_f(fd, buf, len, flags | MSG_NOSIGNAL));
+}
 
-void init_hook(void) {
 
-	if (!read_f) {
-		read_f = dlsym(RTLD_NEXT, "read");
+int socket(int domain, int type, int protocol) {
+	HOOK_SYS(socket);
+
+	int fd = socket_f(domain, type, protocol);
+	if (fd >= 0 && (domain == AF_INET || domain == AF_INET6) &&
+		(type & 0xf) == SOCK_STREAM) {
+		fd_manage(fd, !!(type & SOCK_NONBLOCK));
 	}
+	return fd;
+}
 
-	
-	if (!write_f) {
-		write_f = dlsym(RTLD_NEXT, "write");
+
+int accept(int fd, struct sockaddr *addr, socklen_t *addrlen) {
+	HOOK_SYS(accept);
+
+	int clientfd;
+	if (!fd_blocking(fd)) {
+		clientfd = accept_f(fd, addr, addrlen);
+	} else {
+		while ((clientfd = accept_f(fd, addr, addrlen)) < 0 &&
+			(errno == EAGAIN || errno == EWOULDBLOCK)) {
+			if (fd_wait(fd, POLLIN) < 0) return -1;
+		}
+	}
+	if (clientfd >= 0 && fd_lookup(fd) && fd_lookup(fd)->managed) {
+		fd_manage(clientfd, 0);
 	}
+	return clientfd;
+}
+
+
+int connect(int fd, const struct sockaddr *addr, socklen_t addrlen) {
+	HOOK_SYS(connect);
 
+	int ret = connect_f(fd, addr, addrlen);
+	if (ret == 0 || errno != EINPROGRESS || !fd_blocking(fd)) return ret;
+
+	if (fd_wait(fd, POLLOUT) < 0) return -1;
+
+	int err = 0;
+	socklen_t len = sizeof(err);
+	if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) return -1;
+	if (err) {
+		errno = err;
+		return -1;
+	}
+	return 0;
 }
 
-#endif
 
+// 关闭前撤掉 epoll 注册并叫醒还在等这个 fd 的协程（它们重试时拿到 EBADF）
+// 等待者只能由 fd 所属的调度器摘下，在协程里就先迁移过去；不在协程里关闭别的调度器的 fd 时
+// 内核随关闭自动撤掉注册，但还在等它的协程不会被叫醒
+int close(int fd) {
+	HOOK_SYS(close);
 
+	struct fd_ctx *ctx = fd_lookup(fd);
+	if (ctx && (ctx->managed || ctx->owner)) {
+		if (ctx->owner && ctx->owner != sched && sched && sched->current &&
+			!sched->current->shared) {
+			coroutine_migrate(ctx->owner);
+		}
+		if (ctx->owner && ctx->owner == sched) {
+			if (ctx->armed) epoll_ctl(sched->epfd, EPOLL_CTL_DEL, fd, NULL);
+			if (ctx->reader) coroutine_wake(ctx->reader, 0, 1);
+			if (ctx->writer) coroutine_wake(ctx->writer, 0, 1);
+		}
+		memset(ctx, 0, sizeof(*ctx));
+	}
+	return close_f(fd);
+}
 
-int main() {
 
-	init_hook();
+// 对用户隐藏底层的 O_NONBLOCK，并记下用户自己设的非阻塞
+int fcntl(int fd, int cmd, ...) {
+	HOOK_SYS(fcntl);
+
+	va_list ap;
+	va_start(ap, cmd);
+	void *arg = va_arg(ap, void *);
+	va_end(ap);
+
+	struct fd_ctx *ctx = fd_lookup(fd);
+	if (!ctx || !ctx->managed) return fcntl_f(fd, cmd, arg);
+
+	if (cmd == F_GETFL) {
+		int flags = fcntl_f(fd, cmd);
+		if (flags >= 0 && !ctx->user_nonblock) flags &= ~O_NONBLOCK;
+		return flags;
+	}
+	if (cmd == F_SETFL) {
+		int flags = (int)(intptr_t)arg;
+		int ret = fcntl_f(fd, cmd, flags | O_NONBLOCK);
+		if (ret == 0) ctx->user_nonblock = !!(flags & O_NONBLOCK);
+		return ret;
+	}
+	return fcntl_f(fd, cmd, arg);
+}
+
+
+int poll(struct pollfd *fds, nfds_t nfds, int timeout) {
+	HOOK_SYS(poll);
+
+	if (!sched || !sched->current || timeout == 0) return poll_f(fds, nfds, timeout);
+
+	// 被叫醒后再查一遍：事件可能已被同一 fd 上的别的协程读走，没到期就接着等
+	uint64_t deadline = timeout > 0 ? now_ns() + (uint64_t)timeout * 1000000ull : 0;
+	while (1) {
+		int ret = poll_f(fds, nfds, 0);
+		if (ret != 0) return ret;
+
+		int left = -1;
+		if (timeout > 0) {
+			uint64_t now = now_ns();
+			if (now >= deadline) return 0;
+			left = (int)((deadline - now + 999999) / 1000000);
+		}
+
+		ret = coroutine_wait(fds, nfds, left);
+		if (ret < 0) return -1;
+		if (ret == 0) return poll_f(fds, nfds, 0);
+	}
+}
+
+
+unsigned int sleep(unsigned int seconds) {
+	HOOK_SYS(sleep);
+
+	if (!sched || !sched->current) return sleep_f(seconds);
+	coroutine_sleep_ns((uint64_t)seconds * 1000000000ull);
+	return 0;
+}
+
+
+int usleep(useconds_t usec) {
+	HOOK_SYS(usleep);
+
+	if (!sched || !sched->current) return usleep_f(usec);
+	coroutine_sleep_ns((uint64_t)usec * 1000ull);
+	return 0;
+}
+
+
+
+// 每个连接一个协程，写法和阻塞 IO 一样
+void client_routine(void *arg) {
+
+	int clientfd = (int)(intptr_t)arg;
+
+	while (1) {
+
+		char buffer[128] = {0};
+		int count = read(clientfd, buffer, 128);
+		if (count <= 0) {
+			break;
+		}
+		write(clientfd, buffer, count);
+
+	}
+
+	close(clientfd);
+}
+
+
+static int connections = 0;
+
+void server_routine(void *arg) {
+
+	int sockfd = (int)(intptr_t)arg;
+
+	while (1) {
+
+		struct sockaddr_in clientaddr;
+		socklen_t len = sizeof(clientaddr);
+		int clientfd = accept(sockfd, (struct sockaddr*)&clientaddr, &len);
+		if (clientfd < 0) {
+			perror("accept");
+			sleep(1);	// fd 用尽时让出，等连接关闭
+			continue;
+		}
+
+		if (coroutine_create(client_routine, (void *)(intptr_t)clientfd) < 0) {
+			close(clientfd);
+			continue;
+		}
+		if (__atomic_add_fetch(&connections, 1, __ATOMIC_RELAXED) % 10000 == 0) {
+			printf("accept: %d\n", connections);
+		}
+	}
+}
+
+
+static enum co_stack_mode stack_mode = CO_STACK_SHARED;
+
+// 每个调度器一个 SO_REUSEPORT 监听 socket，由内核把新连接分散到各个核
+void server_init(int index, void *arg) {
+
+	schedule_set_stack_mode(stack_mode);
 
 	int sockfd = socket(AF_INET, SOCK_STREAM, 0);
 
+	int on = 1;
+	setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+
 	struct sockaddr_in serveraddr;
 	memset(&serveraddr, 0, sizeof(struct sockaddr_in));
 
@@ -100,29 +1254,38 @@ int main() {
 
 	if (-1 == bind(sockfd, (struct sockaddr*)&serveraddr, sizeof(struct sockaddr))) {
 		perror("bind");
-		return -1;
+		exit(1);
 	}
 
-	listen(sockfd, 10);
+	listen(sockfd, SOMAXCONN);
 
-	struct sockaddr_in clientaddr;
-	socklen_t len = sizeof(clientaddr);
-	int clientfd = accept(sockfd, (struct sockaddr*)&clientaddr, &len);
-	printf("accept\n");
+	coroutine_create(server_routine, (void *)(intptr_t)sockfd);
+}
 
-	while (1) {
 
-		char buffer[128] = {0};
-		int count = read(clientfd, buffer, 128);
-		if (count == 0) {
-			break;
-		}
-		write(clientfd, buffer, count);
-		printf("sockfd: %d, clientfd: %d, count: %d, buffer: %s\n", sockfd, clientfd, count, buffer);
+// ./hook [shared|pooled] [threads]：默认共享栈、每个核一个调度器
+// pooled 每个连接一块独立栈，占两个 VMA：默认 vm.max_map_count=65530 时约 3 万连接就会
+// mmap 失败，更多连接先 sysctl -w vm.max_map_count=262144
+int main(int argc, char *argv[]) {
 
+	init_hook();
+
+	if (argc > 1 && strcmp(argv[1], "pooled") == 0) {
+		stack_mode = CO_STACK_POOLED;
 	}
+	int threads = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
 
-	return 0;
+	// 没被接管的 fd 仍走原生 write，客户端重置连接不能让整个服务器退出
+	signal(SIGPIPE, SIG_IGN);
+
+	// 十万连接需要放开 fd 上限
+	struct rlimit rlim;
+	if (getrlimit(RLIMIT_NOFILE, &rlim) == 0 && rlim.rlim_cur < rlim.rlim_max) {
+		rlim.rlim_cur = rlim.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rlim);
+	}
+
+	return schedule_run_mt(threads, server_init, NULL);
 
 }
 
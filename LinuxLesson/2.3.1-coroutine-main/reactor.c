@@ -0,0 +1,835 @@
+
+
+
+
+// shell: gcc -O2 -c reactor.c
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <unistd.h>
+#include <pthread.h>
+
+#include "reactor.h"
+
+
+#define REACTOR_MAX_EVENTS		1024
+#define REACTOR_SCRATCH_SIZE	(64 * 1024)		// 2 的幂，rbuf 为空时直接借它来读
+#define REACTOR_READ_CHUNK		(16 * 1024)		// rbuf 里有残留数据时每次至少留出的空间
+#define REACTOR_RBUF_MAX		(256 * 1024)	// 超过就暂停读，等应用消费
+#define REACTOR_ACCEPT_RETRY	100				// fd 耗尽时隔多久重试 accept，毫秒
+
+#define RING_MIN_CAP			512
+#define RING_MAX_CAP			(1u << 30)
+
+
+struct reactor_timer {
+	uint64_t deadline;
+	int heap_idx;
+	reactor_timer_cb cb;
+	void *arg;
+};
+
+struct reactor_task {
+	reactor_task_cb cb;
+	void *arg;
+	struct reactor_task *next;
+};
+
+struct reactor {
+	int epfd;
+	int evfd;
+	int stop;
+	uint64_t now;
+
+	reactor_conn_t *conns;			// 所有未关闭的连接
+	reactor_conn_t *graveyard;		// 引用归零的连接，本轮事件处理完再释放
+
+	reactor_timer_t **timers;
+	int timer_count;
+	int timer_cap;
+
+	pthread_mutex_t post_lock;
+	struct reactor_task *post_head;
+	struct reactor_task *post_tail;
+
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+	char scratch[REACTOR_SCRATCH_SIZE];
+};
+
+
+static uint64_t now_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+// ---------------- 环形缓冲区 ----------------
+
+int ring_reserve(struct ring *r, size_t n) {
+	size_t len = ring_len(r);
+	if (r->cap - len >= n) return 0;
+
+	size_t cap = r->cap ? r->cap : RING_MIN_CAP;
+	while (cap - len < n) {
+		if (cap >= RING_MAX_CAP) return -1;
+		cap <<= 1;
+	}
+
+	char *buf = malloc(cap);
+	if (!buf) return -1;
+
+	struct iovec iov[2];
+	int i, cnt = ring_peek(r, iov);
+	size_t off = 0;
+	for (i = 0; i < cnt; i ++) {
+		memcpy(buf + off, iov[i].iov_base, iov[i].iov_len);
+		off += iov[i].iov_len;
+	}
+
+	free(r->buf);
+	r->buf = buf;
+	r->cap = cap;
+	r->head = 0;
+	r->tail = len;
+	return 0;
+}
+
+int ring_append(struct ring *r, const void *data, size_t len) {
+	if (ring_reserve(r, len) < 0) return -1;
+
+	struct iovec iov[2];
+	int i, cnt = ring_space(r, iov);
+	const char *p = data;
+	size_t left = len;
+	for (i = 0; i < cnt && left > 0; i ++) {
+		size_t n = iov[i].iov_len < left ? iov[i].iov_len : left;
+		memcpy(iov[i].iov_base, p, n);
+		p += n;
+		left -= n;
+	}
+	r->tail += len;
+	return 0;
+}
+
+int ring_peek(const struct ring *r, struct iovec iov[2]) {
+	size_t len = ring_len(r);
+	if (len == 0) return 0;
+
+	uint32_t mask = r->cap - 1;
+	size_t h = r->head & mask;
+	size_t first = r->cap - h;
+
+	iov[0].iov_base = r->buf + h;
+	if (first >= len) {
+		iov[0].iov_len = len;
+		return 1;
+	}
+	iov[0].iov_len = first;
+	iov[1].iov_base = r->buf;
+	iov[1].iov_len = len - first;
+	return 2;
+}
+
+int ring_space(const struct ring *r, struct iovec iov[2]) {
+	size_t free = r->cap - ring_len(r);
+	if (free == 0) return 0;
+
+	uint32_t mask = r->cap - 1;
+	size_t t = r->tail & mask;
+	size_t first = r->cap - t;
+
+	iov[0].iov_base = r->buf + t;
+	if (first >= free) {
+		iov[0].iov_len = free;
+		return 1;
+	}
+	iov[0].iov_len = first;
+	iov[1].iov_base = r->buf;
+	iov[1].iov_len = free - first;
+	return 2;
+}
+
+void ring_produce(struct ring *r, size_t n) {
+	r->tail += n;
+}
+
+void ring_consume(struct ring *r, size_t n) {
+	r->head += n;
+	if (r->head == r->tail) {
+		r->head = r->tail = 0;
+	}
+}
+
+size_t ring_read(struct ring *r, void *dst, size_t len) {
+	struct iovec iov[2];
+	int i, cnt = ring_peek(r, iov);
+	char *p = dst;
+	size_t got = 0;
+
+	for (i = 0; i < cnt && got < len; i ++) {
+		size_t n = iov[i].iov_len < len - got ? iov[i].iov_len : len - got;
+		memcpy(p + got, iov[i].iov_base, n);
+		got += n;
+	}
+	ring_consume(r, got);
+	return got;
+}
+
+void ring_free(struct ring *r) {
+	free(r->buf);
+	memset(r, 0, sizeof(*r));
+}
+
+// 空了就把内存还回去：百万连接大多数时候是空闲的，常驻缓冲区的代价太大
+static void ring_trim(struct ring *r) {
+	if (r->cap && ring_len(r) == 0) ring_free(r);
+}
+
+
+// ---------------- 定时堆 ----------------
+
+static void timer_swap(reactor_timer_t **timers, int i, int j) {
+	reactor_timer_t *t = timers[i];
+	timers[i] = timers[j];
+	timers[j] = t;
+	timers[i]->heap_idx = i;
+	timers[j]->heap_idx = j;
+}
+
+static void timer_sift(reactor_t *r, int i) {
+	reactor_timer_t **timers = r->timers;
+	int n = r->timer_count;
+
+	while (i > 0 && timers[(i - 1) / 2]->deadline > timers[i]->deadline) {
+		timer_swap(timers, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+	while (1) {
+		int l = 2 * i + 1, rr = l + 1, min = i;
+		if (l < n && timers[l]->deadline < timers[min]->deadline) min = l;
+		if (rr < n && timers[rr]->deadline < timers[min]->deadline) min = rr;
+		if (min == i) break;
+		timer_swap(timers, i, min);
+		i = min;
+	}
+}
+
+static int timer_push(reactor_t *r, reactor_timer_t *t) {
+	if (r->timer_count == r->timer_cap) {
+		int cap = r->timer_cap ? r->timer_cap * 2 : 64;
+		reactor_timer_t **timers = realloc(r->timers, sizeof(*timers) * cap);
+		if (!timers) return -1;
+		r->timers = timers;
+		r->timer_cap = cap;
+	}
+	t->heap_idx = r->timer_count++;
+	r->timers[t->heap_idx] = t;
+	timer_sift(r, t->heap_idx);
+	return 0;
+}
+
+static void timer_remove(reactor_t *r, reactor_timer_t *t) {
+	int i = t->heap_idx;
+	if (i < 0) return ;
+
+	t->heap_idx = -1;
+	int last = --r->timer_count;
+	if (i != last) {
+		r->timers[i] = r->timers[last];
+		r->timers[i]->heap_idx = i;
+		timer_sift(r, i);
+	}
+}
+
+reactor_timer_t *reactor_timer_add(reactor_t *r, int ms, reactor_timer_cb cb, void *arg) {
+	reactor_timer_t *t = malloc(sizeof(reactor_timer_t));
+	if (!t) return NULL;
+
+	t->deadline = r->now + (ms > 0 ? ms : 0);
+	t->cb = cb;
+	t->arg = arg;
+	if (timer_push(r, t) < 0) {
+		free(t);
+		return NULL;
+	}
+	return t;
+}
+
+void reactor_timer_cancel(reactor_t *r, reactor_timer_t *t) {
+	if (!t) return ;
+	timer_remove(r, t);
+	free(t);
+}
+
+static int timer_timeout(reactor_t *r) {
+	if (r->timer_count == 0) return -1;
+	uint64_t deadline = r->timers[0]->deadline;
+	return deadline > r->now ? (int)(deadline - r->now) : 0;
+}
+
+static void timer_expire(reactor_t *r) {
+	while (r->timer_count > 0 && r->timers[0]->deadline <= r->now) {
+		reactor_timer_t *t = r->timers[0];
+		timer_remove(r, t);
+
+		int next = t->cb(r, t->arg);
+		if (next > 0) {
+			t->deadline = r->now + next;
+			if (timer_push(r, t) == 0) continue;
+		}
+		free(t);
+	}
+}
+
+
+// ---------------- 连接 ----------------
+
+static reactor_conn_t *conn_new(reactor_t *r, int fd, uint32_t flags,
+	const struct reactor_handler *h, void *user) {
+
+	reactor_conn_t *c = calloc(1, sizeof(reactor_conn_t));
+	if (!c) return NULL;
+
+	c->fd = fd;
+	c->flags = flags;
+	c->refs = 1;			// reactor 自己持有的引用，关闭时释放
+	c->reactor = r;
+	c->handler = h;
+	c->user = user;
+	c->active_ms = r->now;
+
+	uint32_t events = EPOLLIN | EPOLLET;
+	if (!(flags & REACTOR_CONN_LISTEN)) events |= EPOLLOUT | EPOLLRDHUP;
+
+	struct epoll_event ev;
+	ev.events = events;
+	ev.data.ptr = c;
+	if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		free(c);
+		return NULL;
+	}
+
+	c->next = r->conns;
+	if (r->conns) r->conns->prev = c;
+	r->conns = c;
+	return c;
+}
+
+void reactor_conn_hold(reactor_conn_t *c) {
+	c->refs ++;
+}
+
+void reactor_conn_put(reactor_conn_t *c) {
+	if (-- c->refs > 0) return ;
+
+	reactor_t *r = c->reactor;
+	c->next = r->graveyard;
+	r->graveyard = c;
+}
+
+static void conn_close(reactor_conn_t *c, int err) {
+	if (c->flags & REACTOR_CONN_CLOSED) return ;
+	c->flags |= REACTOR_CONN_CLOSED;
+
+	reactor_t *r = c->reactor;
+	if (c->idle_timer) {
+		reactor_timer_cancel(r, c->idle_timer);
+		c->idle_timer = NULL;
+	}
+	if (c->accept_timer) {
+		reactor_timer_cancel(r, c->accept_timer);
+		c->accept_timer = NULL;
+		reactor_conn_put(c);
+	}
+
+	if (c->prev) c->prev->next = c->next;
+	if (c->next) c->next->prev = c->prev;
+	if (r->conns == c) r->conns = c->next;
+	c->prev = c->next = NULL;
+
+	if (!(c->flags & REACTOR_CONN_LISTEN) && c->handler->on_close) c->handler->on_close(c, err);
+
+	// close 会把 fd 从 epoll 里摘掉，本轮 events 里剩下的事件靠 CLOSED 标记跳过
+	close(c->fd);
+	c->fd = -1;
+	reactor_conn_put(c);
+}
+
+static void graveyard_flush(reactor_t *r) {
+	while (r->graveyard) {
+		reactor_conn_t *c = r->graveyard;
+		r->graveyard = c->next;
+		ring_free(&c->rbuf);
+		ring_free(&c->wbuf);
+		free(c);
+	}
+}
+
+// rbuf 为空时直接读进 reactor 的 scratch，回调完还有剩余才拷到连接自己的缓冲区，
+// 请求-应答式的连接一般一次就消费完，整个过程不需要分配内存
+static void conn_readable(reactor_conn_t *c, uint32_t events) {
+	reactor_t *r = c->reactor;
+
+	while (!(c->flags & REACTOR_CONN_CLOSED)) {
+		struct iovec iov[2];
+		int cnt, borrowed = 0;
+
+		if (c->rbuf.cap == 0) {
+			iov[0].iov_base = r->scratch;
+			iov[0].iov_len = REACTOR_SCRATCH_SIZE;
+			cnt = 1;
+			borrowed = 1;
+		} else {
+			if (ring_len(&c->rbuf) >= REACTOR_RBUF_MAX) {
+				c->flags |= REACTOR_CONN_RPAUSED;
+				return ;
+			}
+			if (ring_reserve(&c->rbuf, REACTOR_READ_CHUNK) < 0) {
+				conn_close(c, ENOMEM);
+				return ;
+			}
+			cnt = ring_space(&c->rbuf, iov);
+		}
+
+		size_t want = iov[0].iov_len + (cnt > 1 ? iov[1].iov_len : 0);
+		ssize_t n = readv(c->fd, iov, cnt);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK) conn_close(c, errno);
+			return ;
+		}
+		if (n == 0) {
+			conn_close(c, 0);
+			return ;
+		}
+
+		if (borrowed) {
+			c->rbuf.buf = r->scratch;
+			c->rbuf.cap = REACTOR_SCRATCH_SIZE;
+			c->rbuf.head = 0;
+			c->rbuf.tail = n;
+		} else {
+			ring_produce(&c->rbuf, n);
+		}
+		c->active_ms = r->now;
+
+		c->handler->on_read(c);
+
+		if (borrowed) {
+			struct ring left = c->rbuf;
+			memset(&c->rbuf, 0, sizeof(c->rbuf));
+			if (ring_len(&left) > 0 && !(c->flags & REACTOR_CONN_CLOSED)) {
+				struct iovec data[2];
+				int i, dcnt = ring_peek(&left, data);
+				for (i = 0; i < dcnt; i ++) {
+					if (ring_append(&c->rbuf, data[i].iov_base, data[i].iov_len) < 0) {
+						conn_close(c, ENOMEM);
+						return ;
+					}
+				}
+			}
+		} else {
+			ring_trim(&c->rbuf);
+		}
+
+		// 短读说明接收队列已经读空，省掉一次返回 EAGAIN 的 read；
+		// 带 RDHUP 的事件除外，FIN 和数据一起到时只有继续读才能看到 EOF
+		if ((size_t)n < want && !(events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) return ;
+	}
+}
+
+static void conn_flush(reactor_conn_t *c) {
+	int had = ring_len(&c->wbuf) > 0;
+
+	while (ring_len(&c->wbuf) > 0) {
+		struct msghdr msg;
+		struct iovec iov[2];
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = ring_peek(&c->wbuf, iov);
+
+		ssize_t n = sendmsg(c->fd, &msg, MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK) conn_close(c, errno);
+			return ;	// 等下一次 EPOLLOUT
+		}
+		ring_consume(&c->wbuf, n);
+	}
+	ring_trim(&c->wbuf);
+
+	if (c->flags & REACTOR_CONN_CLOSING) {
+		conn_close(c, 0);
+	} else if (had && c->handler->on_drain) {
+		c->handler->on_drain(c);
+	}
+}
+
+static void conn_connected(reactor_conn_t *c) {
+	int err = 0;
+	socklen_t len = sizeof(err);
+
+	if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) err = errno;
+	if (err) {
+		conn_close(c, err);
+		return ;
+	}
+
+	c->flags &= ~REACTOR_CONN_CONNECTING;
+	c->active_ms = c->reactor->now;
+	if (c->handler->on_open) c->handler->on_open(c);
+}
+
+int reactor_send(reactor_conn_t *c, const void *data, size_t len) {
+	if (c->flags & (REACTOR_CONN_CLOSED | REACTOR_CONN_CLOSING)) return -1;
+
+	size_t off = 0;
+	if (ring_len(&c->wbuf) == 0 && !(c->flags & REACTOR_CONN_CONNECTING)) {
+		while (off < len) {
+			ssize_t n = send(c->fd, (const char *)data + off, len - off, MSG_NOSIGNAL);
+			if (n >= 0) {
+				off += n;
+			} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			} else if (errno != EINTR) {
+				conn_close(c, errno);
+				return -1;
+			}
+		}
+	}
+
+	// 写不完的部分排队，ET 模式下发送缓冲区腾出空间时会来一次 EPOLLOUT
+	if (off < len && ring_append(&c->wbuf, (const char *)data + off, len - off) < 0) {
+		conn_close(c, ENOMEM);
+		return -1;
+	}
+	return 0;
+}
+
+void reactor_close(reactor_conn_t *c) {
+	if (c->flags & REACTOR_CONN_CLOSED) return ;
+
+	if (ring_len(&c->wbuf) == 0) {
+		conn_close(c, 0);
+	} else {
+		c->flags |= REACTOR_CONN_CLOSING;
+	}
+}
+
+void reactor_resume(reactor_conn_t *c) {
+	if (!(c->flags & REACTOR_CONN_RPAUSED)) return ;
+	if (ring_len(&c->rbuf) >= REACTOR_RBUF_MAX) return ;
+
+	c->flags &= ~REACTOR_CONN_RPAUSED;
+	// 暂停期间内核里的数据不会再有新的边沿，直接接着读
+	conn_readable(c, EPOLLRDHUP);
+}
+
+// 惰性续期：读数据时只更新 active_ms，到期时再看是否真的空闲，避免每次读都调整堆
+static int conn_idle_check(reactor_t *r, void *arg) {
+	reactor_conn_t *c = arg;
+	uint64_t expire = c->active_ms + c->idle_ms;
+
+	if (expire > r->now) return (int)(expire - r->now);
+
+	c->idle_timer = NULL;
+	conn_close(c, ETIMEDOUT);
+	return 0;
+}
+
+int reactor_set_idle(reactor_conn_t *c, int ms) {
+	reactor_t *r = c->reactor;
+
+	if (c->idle_timer) {
+		reactor_timer_cancel(r, c->idle_timer);
+		c->idle_timer = NULL;
+	}
+	c->idle_ms = ms;
+	if (ms <= 0 || (c->flags & REACTOR_CONN_CLOSED)) return 0;
+
+	c->active_ms = r->now;
+	c->idle_timer = reactor_timer_add(r, ms, conn_idle_check, c);
+	return c->idle_timer ? 0 : -1;
+}
+
+
+// ---------------- listen / connect ----------------
+
+static int listener_accept(reactor_t *r, void *arg);
+
+static void listener_readable(reactor_conn_t *l) {
+	reactor_t *r = l->reactor;
+
+	while (1) {
+		int fd = accept4(l->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+				// 边沿触发下这次不读完就不会再通知，稍后定时重试；已经在等重试就不再加
+				if (!l->accept_timer) {
+					perror("accept");
+					l->accept_timer = reactor_timer_add(r, REACTOR_ACCEPT_RETRY, listener_accept, l);
+					if (l->accept_timer) reactor_conn_hold(l);
+				}
+			}
+			return ;
+		}
+
+		int nodelay = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+		reactor_conn_t *c = conn_new(r, fd, 0, l->handler, l->user);
+		if (!c) {
+			close(fd);
+			continue;
+		}
+		if (c->handler->on_open) c->handler->on_open(c);
+	}
+}
+
+// conn_close 会取消还没触发的重试，所以这里 listener 一定没关
+static int listener_accept(reactor_t *r, void *arg) {
+	reactor_conn_t *l = arg;
+	l->accept_timer = NULL;
+	listener_readable(l);
+	reactor_conn_put(l);
+	return 0;
+}
+
+reactor_conn_t *reactor_listen(reactor_t *r, const char *ip, int port, int flags,
+	const struct reactor_handler *h, void *user) {
+
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) return NULL;
+
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	if ((flags & REACTOR_REUSEPORT) &&
+		setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+		goto fail;
+	}
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (ip && inet_pton(AF_INET, ip, &addr.sin_addr) != 1) {
+		errno = EINVAL;
+		goto fail;
+	}
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) goto fail;
+	if (listen(fd, SOMAXCONN) < 0) goto fail;
+
+	reactor_conn_t *l = conn_new(r, fd, REACTOR_CONN_LISTEN, h, user);
+	if (!l) goto fail;
+	return l;
+
+fail:
+	close(fd);
+	return NULL;
+}
+
+reactor_conn_t *reactor_connect(reactor_t *r, const struct sockaddr *addr, socklen_t addrlen,
+	const struct sockaddr *local, const struct reactor_handler *h, void *user) {
+
+	int fd = socket(addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) return NULL;
+
+	if (local) {
+		// 端口留到 connect 时再选，这样同一个源地址对不同目的端口可以复用本地端口
+		int on = 1;
+		setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &on, sizeof(on));
+		socklen_t len = local->sa_family == AF_INET6 ?
+			sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+		if (bind(fd, local, len) < 0) goto fail;
+	}
+
+	int nodelay = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+	if (connect(fd, addr, addrlen) < 0 && errno != EINPROGRESS) goto fail;
+
+	// 立即连上的情况也等 EPOLLOUT 再回调 on_open，调用方先拿到连接指针
+	reactor_conn_t *c = conn_new(r, fd, REACTOR_CONN_CONNECTING, h, user);
+	if (!c) goto fail;
+	return c;
+
+fail:
+	close(fd);
+	return NULL;
+}
+
+
+// ---------------- 跨线程投递 ----------------
+
+int reactor_post(reactor_t *r, reactor_task_cb cb, void *arg) {
+	struct reactor_task *task = malloc(sizeof(struct reactor_task));
+	if (!task) return -1;
+
+	task->cb = cb;
+	task->arg = arg;
+	task->next = NULL;
+
+	pthread_mutex_lock(&r->post_lock);
+	int was_empty = r->post_head == NULL;
+	if (r->post_tail) r->post_tail->next = task;
+	else r->post_head = task;
+	r->post_tail = task;
+	pthread_mutex_unlock(&r->post_lock);
+
+	// 队列非空说明已经有人写过 eventfd、reactor 还没取走，不用重复唤醒
+	if (was_empty) {
+		uint64_t one = 1;
+		ssize_t ret = write(r->evfd, &one, sizeof(one));
+		(void)ret;
+	}
+	return 0;
+}
+
+static void post_drain(reactor_t *r) {
+	uint64_t count;
+	ssize_t ret = read(r->evfd, &count, sizeof(count));
+	(void)ret;
+
+	pthread_mutex_lock(&r->post_lock);
+	struct reactor_task *task = r->post_head;
+	r->post_head = r->post_tail = NULL;
+	pthread_mutex_unlock(&r->post_lock);
+
+	while (task) {
+		struct reactor_task *next = task->next;
+		task->cb(r, task->arg);
+		free(task);
+		task = next;
+	}
+}
+
+
+// ---------------- 事件循环 ----------------
+
+reactor_t *reactor_create(void) {
+	reactor_t *r = calloc(1, sizeof(reactor_t));
+	if (!r) return NULL;
+
+	r->epfd = epoll_create1(EPOLL_CLOEXEC);
+	r->evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (r->epfd < 0 || r->evfd < 0) goto fail;
+
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->evfd, &ev) < 0) goto fail;
+
+	pthread_mutex_init(&r->post_lock, NULL);
+	r->now = now_ms();
+	return r;
+
+fail:
+	if (r->epfd >= 0) close(r->epfd);
+	if (r->evfd >= 0) close(r->evfd);
+	free(r);
+	return NULL;
+}
+
+void reactor_destroy(reactor_t *r) {
+	while (r->conns) conn_close(r->conns, ECONNABORTED);
+
+	// 没执行的投递照常执行，里面通常有要 put 的连接引用
+	while (r->post_head) post_drain(r);
+
+	int i;
+	for (i = 0; i < r->timer_count; i ++) free(r->timers[i]);
+	free(r->timers);
+
+	graveyard_flush(r);
+
+	close(r->epfd);
+	close(r->evfd);
+	pthread_mutex_destroy(&r->post_lock);
+	free(r);
+}
+
+void reactor_stop(reactor_t *r) {
+	__atomic_store_n(&r->stop, 1, __ATOMIC_RELEASE);
+
+	uint64_t one = 1;
+	ssize_t ret = write(r->evfd, &one, sizeof(one));
+	(void)ret;
+}
+
+uint64_t reactor_now(reactor_t *r) {
+	return r->now;
+}
+
+static void reactor_dispatch(reactor_conn_t *c, uint32_t events) {
+	if (c->flags & REACTOR_CONN_CLOSED) return ;
+
+	if (c->flags & REACTOR_CONN_LISTEN) {
+		listener_readable(c);
+		return ;
+	}
+
+	reactor_conn_hold(c);
+
+	if (c->flags & REACTOR_CONN_CONNECTING) {
+		if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) conn_connected(c);
+	}
+	if (!(c->flags & (REACTOR_CONN_CLOSED | REACTOR_CONN_CONNECTING)) &&
+		(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+		if (c->flags & REACTOR_CONN_RPAUSED) {
+			// 暂停期间只记下边沿，等 reactor_resume 再读；出错时仍需读到错误并关闭
+			if (events & (EPOLLHUP | EPOLLERR)) conn_close(c, ECONNRESET);
+		} else {
+			conn_readable(c, events);
+		}
+	}
+	if (!(c->flags & (REACTOR_CONN_CLOSED | REACTOR_CONN_CONNECTING)) && (events & EPOLLOUT)) {
+		conn_flush(c);
+	}
+
+	reactor_conn_put(c);
+}
+
+int reactor_run(reactor_t *r) {
+	int ret = 0;
+
+	while (!__atomic_load_n(&r->stop, __ATOMIC_ACQUIRE)) {
+		int nready = epoll_wait(r->epfd, r->events, REACTOR_MAX_EVENTS, timer_timeout(r));
+		r->now = now_ms();
+
+		if (nready < 0) {
+			if (errno == EINTR) continue;
+			ret = -1;
+			break;
+		}
+
+		int i;
+		for (i = 0; i < nready; i ++) {
+			reactor_conn_t *c = r->events[i].data.ptr;
+			if (c == NULL) post_drain(r);
+			else reactor_dispatch(c, r->events[i].events);
+		}
+
+		timer_expire(r);
+		graveyard_flush(r);
+	}
+
+	return ret;
+}
@@ -0,0 +1,138 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/**
+ * 从 server_mulport_epoll.c 中抽出来的 reactor：
+ *   一个 reactor 就是一个 epoll 循环，只在创建它的线程里跑，连接、定时器都归它所有
+ *   多核时每个线程一个 reactor，listen 用 SO_REUSEPORT 让内核分发连接
+ *
+ *   边沿触发    连接注册 EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET，只 add 一次不再 mod
+ *   读          每次事件读到 EAGAIN（或短读）为止，数据放进 rbuf 后回调 on_read
+ *   写          reactor_send 先直接 send，写不完的部分进 wbuf，
+ *               内核发送缓冲区腾出空间时的 EPOLLOUT 边沿再把 wbuf 刷出去
+ *   定时器      最小堆，epoll_wait 的超时取堆顶
+ *   跨线程      reactor_post 把回调投递给 reactor 线程执行（eventfd 唤醒），
+ *               线程池只做计算，结果 post 回来由 reactor 写，不在工作线程里碰 socket
+ *
+ * 除 reactor_post / reactor_stop 以外的接口都只能在 reactor 线程里调用
+ */
+
+// ---------------- 环形缓冲区 ----------------
+
+// cap 为 2 的幂，head / tail 自由增长，取模用 & (cap - 1)；cap 为 0 表示还没分配
+struct ring {
+	char *buf;
+	uint32_t cap;
+	uint32_t head;
+	uint32_t tail;
+};
+
+static inline size_t ring_len(const struct ring *r) {
+	return r->tail - r->head;
+}
+
+// 保证至少 n 字节空闲，不够时按 2 倍扩容
+int ring_reserve(struct ring *r, size_t n);
+int ring_append(struct ring *r, const void *data, size_t len);
+// 可读数据最多分两段，返回段数
+int ring_peek(const struct ring *r, struct iovec iov[2]);
+// 空闲空间最多分两段，返回段数
+int ring_space(const struct ring *r, struct iovec iov[2]);
+void ring_produce(struct ring *r, size_t n);
+void ring_consume(struct ring *r, size_t n);
+// 拷出并消费至多 len 字节，返回实际字节数
+size_t ring_read(struct ring *r, void *dst, size_t len);
+void ring_free(struct ring *r);
+
+
+// ---------------- reactor ----------------
+
+typedef struct reactor reactor_t;
+typedef struct reactor_conn reactor_conn_t;
+typedef struct reactor_timer reactor_timer_t;
+
+// 返回下次触发的毫秒数，返回 0 则定时器被释放；不能在回调里 cancel 自己
+typedef int (*reactor_timer_cb)(reactor_t *r, void *arg);
+typedef void (*reactor_task_cb)(reactor_t *r, void *arg);
+
+struct reactor_handler {
+	void (*on_open)(reactor_conn_t *c);				// accept 到的连接，或 connect 完成
+	void (*on_read)(reactor_conn_t *c);				// rbuf 里有新数据，处理完用 ring_consume 消费
+	void (*on_drain)(reactor_conn_t *c);			// 积压的 wbuf 刚被 EPOLLOUT 刷空，可为 NULL
+	void (*on_close)(reactor_conn_t *c, int err);	// 关闭前调用；err 为 0 表示对端正常关闭
+};
+
+enum {
+	REACTOR_CONN_LISTEN		= 1 << 0,
+	REACTOR_CONN_CONNECTING	= 1 << 1,
+	REACTOR_CONN_CLOSED		= 1 << 2,
+	REACTOR_CONN_CLOSING	= 1 << 3,	// wbuf 写完后关闭
+	REACTOR_CONN_RPAUSED	= 1 << 4,	// rbuf 满，暂停读
+};
+
+struct reactor_conn {
+	int fd;
+	uint32_t flags;
+	int refs;
+	reactor_t *reactor;
+	const struct reactor_handler *handler;
+	void *user;						// accept 到的连接继承 listener 的 user
+
+	struct ring rbuf;
+	struct ring wbuf;
+
+	reactor_timer_t *idle_timer;
+	uint64_t active_ms;				// 最近一次读到数据的时间
+	int idle_ms;
+	reactor_timer_t *accept_timer;	// listener：fd 耗尽后重试 accept，同时最多一个
+
+	reactor_conn_t *prev;
+	reactor_conn_t *next;
+};
+
+reactor_t *reactor_create(void);
+// 关闭剩下的连接（会回调 on_close）并释放所有资源
+void reactor_destroy(reactor_t *r);
+// 跑事件循环直到 reactor_stop，出错返回 -1
+int reactor_run(reactor_t *r);
+// 任意线程可调用
+void reactor_stop(reactor_t *r);
+// 本轮循环缓存的单调时钟，毫秒
+uint64_t reactor_now(reactor_t *r);
+
+enum {
+	REACTOR_REUSEPORT		= 1 << 0,
+};
+
+// 监听 ip:port，ip 为 NULL 时监听所有地址
+reactor_conn_t *reactor_listen(reactor_t *r, const char *ip, int port, int flags,
+	const struct reactor_handler *h, void *user);
+// 非阻塞 connect，完成后回调 on_open；local 非 NULL 时先 bind 到该地址
+reactor_conn_t *reactor_connect(reactor_t *r, const struct sockaddr *addr, socklen_t addrlen,
+	const struct sockaddr *local, const struct reactor_handler *h, void *user);
+
+// 发送，写不完的部分进 wbuf；连接已关闭或出错时返回 -1
+int reactor_send(reactor_conn_t *c, const void *data, size_t len);
+// wbuf 里的数据写完后关闭
+void reactor_close(reactor_conn_t *c);
+// 在 on_read 之外消费了 rbuf 后调用，恢复因 rbuf 满而暂停的读
+void reactor_resume(reactor_conn_t *c);
+// ms 内没读到数据就以 ETIMEDOUT 关闭，0 取消
+int reactor_set_idle(reactor_conn_t *c, int ms);
+
+// 跨回调持有连接（比如交给线程池处理期间），关闭后内存延迟到最后一次 put 才释放
+void reactor_conn_hold(reactor_conn_t *c);
+void reactor_conn_put(reactor_conn_t *c);
+
+reactor_timer_t *reactor_timer_add(reactor_t *r, int ms, reactor_timer_cb cb, void *arg);
+void reactor_timer_cancel(reactor_t *r, reactor_timer_t *t);
+
+// 任意线程可调用：在 reactor 线程里执行 cb(r, arg)
+int reactor_post(reactor_t *r, reactor_task_cb cb, void *arg);
+
+#endif
@@ -1,63 +1,40 @@
 
 
 
+// shell: gcc -O2 -o server_mulport_epoll server_mulport_epoll.c reactor.c -lpthread
+// ./server_mulport_epoll [reactors] [workers] [idle_sec]
+//   reactors  reactor 线程数，每个 reactor 都用 SO_REUSEPORT 监听全部 MAX_PORT 个端口，内核把连接分到各个线程
+//   workers   0 表示在 reactor 线程里直接回显；大于 0 时消息交给线程池处理，
+//             工作线程只做计算，结果 reactor_post 回 reactor 线程发送，不在工作线程里 poll / recv / send
+//   idle_sec  大于 0 时关闭这么久没有数据的连接
+
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include <sys/types.h>
 #include <sys/socket.h>
-#include <sys/epoll.h>
-#include <sys/poll.h>
 #include <sys/time.h>
 
 #include <errno.h>
-#include <netinet/tcp.h>
-#include <arpa/inet.h>
-#include <netdb.h>
-#include <fcntl.h>
+#include <sched.h>
 
 #include <unistd.h>
 #include <pthread.h>
 
+#include "reactor.h"
+
 #define SERVER_PORT		8080
-#define SERVER_IP		"127.0.0.1"
-#define MAX_BUFFER		128
-#define MAX_EPOLLSIZE	100000
+#define MAX_BUFFER		4096
 #define MAX_THREAD		80
 #define MAX_PORT		100
-
-#define CPU_CORES_SIZE	8
+#define MAX_REACTOR		64
+#define STATS_INTERVAL	1000	// 毫秒
 
 #define TIME_SUB_MS(tv1, tv2)  ((tv1.tv_sec - tv2.tv_sec) * 1000 + (tv1.tv_usec - tv2.tv_usec) / 1000)
 
-static int ntySetNonblock(int fd) {
-	int flags;
-
-	flags = fcntl(fd, F_GETFL, 0);
-	if (flags < 0) return flags;
-	flags |= O_NONBLOCK;
-	if (fcntl(fd, F_SETFL, flags) < 0) return -1;
-	return 0;
-}
-
-static int ntySetReUseAddr(int fd) {
-	int reuse = 1;
-	return setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof(reuse));
-}
-
-static int ntySetAlive(int fd) {
-	int alive = 1;
-	int idle = 60;
-	int interval = 5;
-	int count = 2;
-
-	setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, (void*)&alive, sizeof(alive));
-	setsockopt(fd, SOL_TCP, TCP_KEEPIDLE, (void*)&idle, sizeof(idle));
-	setsockopt(fd, SOL_TCP, TCP_KEEPINTVL, (void*)&interval, sizeof(interval));
-	setsockopt(fd, SOL_TCP, TCP_KEEPCNT, (void*)&count, sizeof(count));
-}
-
 
 /** **** ******** **************** thread pool **************** ******** **** **/
 
@@ -187,380 +164,224 @@ void workqueue_add_job(workqueue_t *workqueue, job_t *job) {
 }
 
 static workqueue_t workqueue;
-void threadpool_init(void) {
-	workqueue_init(&workqueue, MAX_THREAD);
+void threadpool_init(int numWorkers) {
+	workqueue_init(&workqueue, numWorkers);
 }
 
 
 /** **** ******** **************** thread pool **************** ******** **** **/
 
-typedef struct client {
-	int fd;
-	char rBuffer[MAX_BUFFER];
-	int length;
-} client_t;
-
-void *client_cb(void *arg) {
-	int clientfd = *(int *)arg;
-	char buffer[MAX_BUFFER] = {0};
-
-	int childpid = getpid();
-
-	while (1) {
-		bzero(buffer, MAX_BUFFER);
-		ssize_t length = recv(clientfd, buffer, MAX_BUFFER, 0); //bio
-		if (length > 0) {
-			//printf(" PID:%d --> buffer: %s\n", childpid, buffer);
-
-			int sLen = send(clientfd, buffer, length, 0);
-			//printf(" PID:%d --> sLen: %d\n", childpid, sLen);
-		} else if (length == 0) {
-			printf(" PID:%d client disconnect\n", childpid);
-			break;
-		} else {
-			printf(" PID:%d errno:%d\n", childpid, errno);
-			break;
-		}
-	}
-}
+// 每个 reactor 线程一份，只有自己的线程写，统计定时器用原子读
+typedef struct server {
+	int index;
+	pthread_t thread;
+	reactor_t *reactor;
 
+	uint64_t accepted;
+	uint64_t closed;
+	uint64_t reads;
+	uint64_t bytes;
+} __attribute__((aligned(64))) server_t;
 
-static int nRecv(int sockfd, void *data, size_t length, int *count) {
-	int left_bytes;
-	int read_bytes;
-	int res;
-	int ret_code;
+static server_t servers[MAX_REACTOR];
+static int nReactor = 1;
+static int nWorker = 0;
+static int idleMs = 0;
 
-	unsigned char *p;
+static __thread server_t *curServer;
 
-	struct pollfd pollfds;
-	pollfds.fd = sockfd;
-	pollfds.events = ( POLLIN | POLLERR | POLLHUP );
+#define STAT_ADD(field, n)	__atomic_fetch_add(&curServer->field, (n), __ATOMIC_RELAXED)
+#define STAT_GET(s, field)	__atomic_load_n(&(s)->field, __ATOMIC_RELAXED)
 
-	read_bytes = 0;
-	ret_code = 0;
-	p = (unsigned char *)data;
-	left_bytes = length;
+// 线程池模式下一条消息一个 client_t：job 嵌在里面，省一次分配
+typedef struct client {
+	job_t job;
+	reactor_conn_t *conn;
+	char rBuffer[MAX_BUFFER];
+	int length;
+} client_t;
 
-	while (left_bytes > 0) {
+static void client_dispatch(reactor_conn_t *c);
 
-		read_bytes = recv(sockfd, p, left_bytes, 0);
-		if (read_bytes > 0) {
-			left_bytes -= read_bytes;
-			p += read_bytes;
-			continue;
- 		} else if (read_bytes < 0) {
-			if (!(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
-				ret_code = (errno != 0 ? errno : EINTR);
-			}
-		} else {
-			ret_code = ENOTCONN;
-			break;
-		}
-		
-		res = poll(&pollfds, 1, 5);
-		if (pollfds.revents & POLLHUP) {
-			ret_code = ENOTCONN;
-			break;
-		}
-		if (res < 0) {
-			if (errno == EINTR) {
-				continue;
-			}
-			ret_code = (errno != 0 ? errno : EINTR);
-		} else if (res == 0) {
-			ret_code = ETIMEDOUT;
-			break;
-		}
+// reactor 线程：把工作线程的处理结果写回去，再派发积压的数据
+static void client_reply(reactor_t *r, void *arg) {
+	client_t *rClient = (client_t *)arg;
+	reactor_conn_t *c = rClient->conn;
 
+	c->user = NULL;
+	if (!(c->flags & REACTOR_CONN_CLOSED)) {
+		reactor_send(c, rClient->rBuffer, rClient->length);
+		client_dispatch(c);
+		reactor_resume(c);
 	}
 
-	if (count != NULL) {
-		*count = length - left_bytes;
-	}
-	//printf("nRecv:%s, ret_code:%d, count:%d\n", (char*)data, ret_code, *count);
+	free(rClient);
+	reactor_conn_put(c);
+}
 
+// 工作线程：只做计算，不碰 socket
+static void client_job(job_t *job) {
+	client_t *rClient = (client_t *)job->user_data;
 
-	return ret_code;
-}
+	// 业务处理放在这里，回显服务原样返回
 
-void epoll_et_loop(int sockfd)
-{
-    char buffer[MAX_BUFFER];
-    int ret;
-
-    while (1)
-    {
-        memset(buffer, 0, MAX_BUFFER);
-        ret = recv(sockfd, buffer, MAX_BUFFER, 0);
-        if (ret == -1)
-        {
-            if (errno == EAGAIN || errno == EWOULDBLOCK)
-            {
-                printf(" read all data\n");
-                break;
-            }
-            close(sockfd);
-            break;
-        }
-        else if (ret == 0)
-        {
-            printf(" disconnect\n");
-            close(sockfd);
-            break;
-        }
-        else
-            printf("Recv:%s, %d Bytes\n", buffer, ret);
-    }
-    
+	if (reactor_post(rClient->conn->reactor, client_reply, rClient) < 0) {
+		perror("reactor_post");
+	}
 }
 
-static int nSend(int sockfd, const void *buffer, int length, int flags) {
+// 每个连接同时只有一个任务在线程池里，回显顺序和收到的顺序一致；
+// 处理期间新到的数据留在 rbuf，积压到上限时 reactor 暂停读这个连接
+static void client_dispatch(reactor_conn_t *c) {
+	if (c->user != NULL || ring_len(&c->rbuf) == 0) return ;
 
-	int wrotelen = 0;
-	int writeret = 0;
+	client_t *rClient = (client_t *)malloc(sizeof(client_t));
+	if (rClient == NULL) {
+		reactor_close(c);
+		return ;
+	}
 
-	unsigned char *p = (unsigned char *)buffer;
+	rClient->conn = c;
+	rClient->length = ring_read(&c->rbuf, rClient->rBuffer, MAX_BUFFER);
+	rClient->job.job_function = client_job;
+	rClient->job.user_data = rClient;
 
-	struct pollfd pollfds = {0};
-	pollfds.fd = sockfd;
-	pollfds.events = ( POLLOUT | POLLERR | POLLHUP );
+	c->user = rClient;
+	reactor_conn_hold(c);
+	workqueue_add_job(&workqueue, &rClient->job);
+}
 
-	do {
-		int result = poll( &pollfds, 1, 5);
-		if (pollfds.revents & POLLHUP) {
-			
-			printf(" ntySend errno:%d, revent:%x\n", errno, pollfds.revents);
-			return -1;
-		}
+static void client_open(reactor_conn_t *c) {
+	STAT_ADD(accepted, 1);
+	if (idleMs > 0) reactor_set_idle(c, idleMs);
+}
 
-		if (result < 0) {
-			if (errno == EINTR) continue;
+static void client_read(reactor_conn_t *c) {
+	size_t length = ring_len(&c->rbuf);
 
-			printf(" ntySend errno:%d, result:%d\n", errno, result);
-			return -1;
-		} else if (result == 0) {
-		
-			printf(" ntySend errno:%d, socket timeout \n", errno);
-			return -1;
-		}
+	STAT_ADD(reads, 1);
+	STAT_ADD(bytes, length);
 
-		writeret = send( sockfd, p + wrotelen, length - wrotelen, flags );
-		if( writeret <= 0 )
-		{
-			break;
-		}
-		wrotelen += writeret ;
+	if (nWorker > 0) {
+		client_dispatch(c);
+		return ;
+	}
 
-	} while (wrotelen < length);
-	
-	return wrotelen;
+	struct iovec iov[2];
+	int i, cnt = ring_peek(&c->rbuf, iov);
+	for (i = 0; i < cnt; i ++) {
+		if (reactor_send(c, iov[i].iov_base, iov[i].iov_len) < 0) return ;
+	}
+	ring_consume(&c->rbuf, length);
 }
 
+static void client_close(reactor_conn_t *c, int err) {
+	STAT_ADD(closed, 1);
+	if (err && err != ECONNRESET && err != EPIPE && err != ETIMEDOUT) {
+		printf(" fd:%d errno:%d\n", c->fd, err);
+	}
+}
 
-static int curfds = 1;
-static int nRun = 0;
-	
-
-void client_job(job_t *job) {
-
+static const struct reactor_handler client_handler = {
+	.on_open = client_open,
+	.on_read = client_read,
+	.on_close = client_close,
+};
 
-	client_t *rClient = (client_t*)job->user_data;
-	int clientfd = rClient->fd;
 
-	char buffer[MAX_BUFFER];
-	bzero(buffer, MAX_BUFFER);
+static struct timeval tv_begin;
+static uint64_t last_accepted, last_reads, last_bytes;
 
-	int length = 0;
-	int ret = nRecv(clientfd, buffer, MAX_BUFFER, &length);
-	if (length > 0) {	
-		if (nRun || buffer[0] == 'a') {		
-			printf(" TcpRecv --> curfds : %d, buffer: %s\n", curfds, buffer);
-			
-			nSend(clientfd, buffer, strlen(buffer), 0);
-		}
+static int server_stats(reactor_t *r, void *arg) {
+	uint64_t accepted = 0, closed = 0, reads = 0, bytes = 0;
+	int i;
 
-	} else if (ret == ENOTCONN) {
-		curfds --;
-		close(clientfd);
-	} else {
-		
+	for (i = 0; i < nReactor; i ++) {
+		accepted += STAT_GET(&servers[i], accepted);
+		closed += STAT_GET(&servers[i], closed);
+		reads += STAT_GET(&servers[i], reads);
+		bytes += STAT_GET(&servers[i], bytes);
 	}
 
-	free(rClient);
-	free(job);
-}
-
-void client_data_process(int clientfd) {
-
-	char buffer[MAX_BUFFER];
-	bzero(buffer, MAX_BUFFER);
-	int length = 0;
-	int ret = nRecv(clientfd, buffer, MAX_BUFFER, &length);
-	if (length > 0) {	
-		if (nRun || buffer[0] == 'a') {		
-			printf(" TcpRecv --> curfds : %d, buffer: %s\n", curfds, buffer);
-			
-			nSend(clientfd, buffer, strlen(buffer), 0);
-		}
-
-	} else if (ret == ENOTCONN) {
-		curfds --;
-		close(clientfd);
-	} else {
-		
+	if (accepted != last_accepted || reads != last_reads) {
+		struct timeval tv_cur;
+		gettimeofday(&tv_cur, NULL);
+		int time_used = TIME_SUB_MS(tv_cur, tv_begin);
+		if (time_used <= 0) time_used = 1;
+
+		printf("connections: %llu, accept/s: %llu, read/s: %llu, MB/s: %.2f\n",
+			(unsigned long long)(accepted - closed),
+			(unsigned long long)((accepted - last_accepted) * 1000 / time_used),
+			(unsigned long long)((reads - last_reads) * 1000 / time_used),
+			(double)(bytes - last_bytes) * 1000 / time_used / (1024 * 1024));
 	}
 
+	gettimeofday(&tv_begin, NULL);
+	last_accepted = accepted;
+	last_reads = reads;
+	last_bytes = bytes;
+	return STATS_INTERVAL;
 }
 
+static void *server_thread(void *arg) {
+	server_t *server = (server_t *)arg;
 
-
-int listenfd(int fd, int *fds) {
-	int i = 0;
-
-	for (i = 0;i < MAX_PORT;i ++) {
-		if (fd == *(fds+i)) return *(fds+i);
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu > 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(server->index % ncpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
 	}
-	return 0;
+
+	curServer = server;
+	if (reactor_run(server->reactor) < 0) perror("reactor_run");
+	return NULL;
 }
 
-int main(void) {
-	int i = 0;
-	int sockfds[MAX_PORT] = {0};
+int main(int argc, char *argv[]) {
+	int i, j;
 
-	printf("C1000K Server Start\n");
-	
-	threadpool_init(); //
+	nReactor = argc > 1 ? atoi(argv[1]) : 1;
+	nWorker = argc > 2 ? atoi(argv[2]) : 0;
+	idleMs = argc > 3 ? atoi(argv[3]) * 1000 : 0;
+	if (nReactor < 1) nReactor = 1;
+	if (nReactor > MAX_REACTOR) nReactor = MAX_REACTOR;
+	if (nWorker < 0) nWorker = 0;
+	if (nWorker > MAX_THREAD) nWorker = MAX_THREAD;
 
-	int epoll_fd = epoll_create(MAX_EPOLLSIZE); 
+	printf("C1000K Server Start, reactors: %d, workers: %d\n", nReactor, nWorker);
 
-	for (i = 0;i < MAX_PORT;i ++) {
+	if (nWorker > 0) threadpool_init(nWorker);
 
-		int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-		if (sockfd < 0) {
-			perror("socket");
+	for (i = 0;i < nReactor;i ++) {
+		servers[i].index = i;
+		servers[i].reactor = reactor_create();
+		if (servers[i].reactor == NULL) {
+			perror("reactor_create");
 			return 1;
 		}
 
-		struct sockaddr_in addr;
-		memset(&addr, 0, sizeof(struct sockaddr_in));
-		
-		addr.sin_family = AF_INET;
-		addr.sin_port = htons(SERVER_PORT+i);
-		addr.sin_addr.s_addr = INADDR_ANY;
-
-		if (bind(sockfd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in)) < 0) {
-			perror("bind");
-			return 2;
-		}
-
-		if (listen(sockfd, 5) < 0) {
-			perror("listen");
-			return 3;
+		for (j = 0;j < MAX_PORT;j ++) {
+			if (reactor_listen(servers[i].reactor, NULL, SERVER_PORT + j,
+				nReactor > 1 ? REACTOR_REUSEPORT : 0, &client_handler, NULL) == NULL) {
+				perror("listen");
+				return 2;
+			}
 		}
-
-		sockfds[i] = sockfd;
-		printf("C1000K Server Listen on Port:%d\n", SERVER_PORT+i);
-
-		struct epoll_event ev;
-		 
-		ev.events = EPOLLIN | EPOLLET; //EPOLLLT
-		ev.data.fd = sockfd;
-		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sockfd, &ev);  
 	}
+	printf("C1000K Server Listen on Port:%d-%d\n", SERVER_PORT, SERVER_PORT + MAX_PORT - 1);
 
-	struct timeval tv_begin;
 	gettimeofday(&tv_begin, NULL);
-	
-	struct epoll_event events[MAX_EPOLLSIZE];
+	reactor_timer_add(servers[0].reactor, STATS_INTERVAL, server_stats, NULL);
 
-	while (1) {
-
-		int nfds = epoll_wait(epoll_fd, events, curfds, 5);  //是不是秘书给累死。
-		if (nfds == -1) {
-			perror("epoll_wait");
-			break;
-		}
-		for (i = 0;i < nfds;i ++) {
-
-			int sockfd = listenfd(events[i].data.fd, sockfds);
-			if (sockfd) {
-				struct sockaddr_in client_addr;
-				memset(&client_addr, 0, sizeof(struct sockaddr_in));
-				socklen_t client_len = sizeof(client_addr);
-				
-				int clientfd = accept(sockfd, (struct sockaddr*)&client_addr, &client_len);
-				if (clientfd < 0) {
-					perror("accept");
-					return 4;
-				}
-				
-				if (curfds ++ > 1000 * 1000) {
-					nRun = 1;
-				}
-#if 0
-				printf(" Client %d: %d.%d.%d.%d:%d \n", curfds, *(unsigned char*)(&client_addr.sin_addr.s_addr), *((unsigned char*)(&client_addr.sin_addr.s_addr)+1),													
-							*((unsigned char*)(&client_addr.sin_addr.s_addr)+2), *((unsigned char*)(&client_addr.sin_addr.s_addr)+3),													
-							client_addr.sin_port);
-#elif 0
-				if(curfds % 1000 == 999) {	
-					printf("connections: %d, fd: %d\n", curfds, clientfd);			
-				}
-#else
-				if (curfds % 1000 == 999) {
-					struct timeval tv_cur;
-					memcpy(&tv_cur, &tv_begin, sizeof(struct timeval));
-					
-					gettimeofday(&tv_begin, NULL);
-
-					int time_used = TIME_SUB_MS(tv_begin, tv_cur);
-					printf("connections: %d, sockfd:%d, time_used:%d\n", curfds, clientfd, time_used);
-				}
-#endif
-				ntySetNonblock(clientfd);
-				ntySetReUseAddr(clientfd);
-
-				struct epoll_event ev;
-				ev.events = EPOLLIN | EPOLLET | EPOLLOUT;
-				ev.data.fd = clientfd;
-				epoll_ctl(epoll_fd, EPOLL_CTL_ADD, clientfd, &ev);
-
-			} else {
-
-				int clientfd = events[i].data.fd;
-#if 1  //1593ms
-				if (nRun) {
-					printf(" New Data is Comming\n");
-					client_data_process(clientfd);
-				} else {
-
-				//	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, clientfd, &ev);
-
-
-					client_t *rClient = (client_t*)malloc(sizeof(client_t));
-					memset(rClient, 0, sizeof(client_t));				
-					rClient->fd = clientfd;
-					
-					job_t *job = malloc(sizeof(job_t));
-					job->job_function = client_job;
-					job->user_data = rClient;
-					workqueue_add_job(&workqueue, job);
-
-				
-				}
-
-#else  
-				client_data_process(clientfd); // 7300ms 
-				
-#endif
-			}
+	for (i = 1;i < nReactor;i ++) {
+		if (pthread_create(&servers[i].thread, NULL, server_thread, &servers[i])) {
+			perror("pthread_create");
+			return 3;
 		}
-		
 	}
-}
-
-
-
-
-
+	server_thread(&servers[0]);
 
+	return 0;
+}
@@ -0,0 +1,168 @@
+#ifndef EVENTCOUNT_H
+#define EVENTCOUNT_H
+
+/**
+ * 事件计数（eventcount）：给无锁/自旋锁队列用的休眠与唤醒原语
+ * 等待方：
+ *   key = eventcount_prepare_wait(ec);
+ *   if (条件已成立) eventcount_cancel_wait(ec);
+ *   else            eventcount_wait(ec, key);
+ * 通知方先让条件成立（例如入队），再调用 eventcount_notify。
+ * epoch 在每次通知时递增：prepare 之后发生的通知会让 futex_wait 因值已改变而立即返回，
+ * 不会丢失唤醒。state 同时记录等待者数与已发出、尚未被等待者消化的唤醒数：
+ * 只有等待者多于在途唤醒时通知方才进入内核。被唤醒的线程真正运行前，
+ * 后续的通知不会重复 FUTEX_WAKE（单核/超售时尤其明显）
+ * 编译时定义 USE_PTHREAD_COND 换成 mutex + cond 实现（每次通知都 signal），用于对比
+ */
+
+#ifndef USE_PTHREAD_COND
+
+#include <limits.h>
+#include <time.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "atomic.h"
+
+#ifdef __STDC_NO_ATOMICS__
+#error "eventcount.h requires C11 atomics"
+#endif
+
+#define EVENTCOUNT_WAITER_ (1ull << 32)
+
+typedef struct eventcount_s {
+  STD_ atomic_uint epoch;    // futex 字
+  STD_ atomic_ullong state;  // 高 32 位：已 prepare 未返回的等待者；低 32 位：在途唤醒
+} eventcount_t;
+
+static inline int eventcount_init(eventcount_t *ec) {
+  STD_ atomic_init(&ec->epoch, 0u);
+  STD_ atomic_init(&ec->state, 0ull);
+  return 0;
+}
+
+static inline void eventcount_destroy(eventcount_t *ec) { (void)ec; }
+
+static inline unsigned eventcount_prepare_wait(eventcount_t *ec) {
+  STD_ atomic_fetch_add(&ec->state, EVENTCOUNT_WAITER_);
+  // 与 notify 中的栅栏配对：要么通知方看到这个等待者，要么这里之后的条件检查看到新数据
+  STD_ atomic_thread_fence(STD_ memory_order_seq_cst);
+  return STD_ atomic_load(&ec->epoch);
+}
+
+// 等待者离开：移除自己，并顺带消化一个在途唤醒
+static inline void eventcount_cancel_wait(eventcount_t *ec) {
+  unsigned long long state = STD_ atomic_load_explicit(&ec->state, STD_ memory_order_relaxed);
+  unsigned long long next;
+  do {
+    next = state - EVENTCOUNT_WAITER_;
+    if ((unsigned)next != 0)
+      next--;
+  } while (!STD_ atomic_compare_exchange_weak(&ec->state, &state, next));
+}
+
+// timeout_ns < 0 表示不限时
+static inline void eventcount_wait_timeout(eventcount_t *ec, unsigned key, long long timeout_ns) {
+  struct timespec ts, *pts = NULL;
+  if (timeout_ns >= 0) {
+    ts.tv_sec = timeout_ns / 1000000000;
+    ts.tv_nsec = timeout_ns % 1000000000;
+    pts = &ts;
+  }
+  // epoch 已不等于 key 时内核直接返回 EAGAIN；超时或被信号打断也直接返回，调用方会重新检查条件
+  syscall(SYS_futex, (unsigned *)&ec->epoch, FUTEX_WAIT_PRIVATE, key, pts, NULL, 0);
+  eventcount_cancel_wait(ec);
+}
+
+static inline void eventcount_wait(eventcount_t *ec, unsigned key) {
+  eventcount_wait_timeout(ec, key, -1);
+}
+
+static inline void eventcount_notify(eventcount_t *ec, int all) {
+  STD_ atomic_thread_fence(STD_ memory_order_seq_cst);
+  unsigned long long state = STD_ atomic_load_explicit(&ec->state, STD_ memory_order_relaxed);
+  unsigned long long next;
+  do {
+    unsigned waiters = (unsigned)(state >> 32), signals = (unsigned)state;
+    if (signals >= waiters)
+      return; // 没有等待者，或每个等待者都已有唤醒在途
+    next = all ? (state & ~0xffffffffull) | waiters : state + 1;
+  } while (!STD_ atomic_compare_exchange_weak(&ec->state, &state, next));
+  STD_ atomic_fetch_add(&ec->epoch, 1u);
+  syscall(SYS_futex, (unsigned *)&ec->epoch, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, NULL, NULL, 0);
+}
+
+#else
+
+#include <pthread.h>
+#include <time.h>
+
+typedef struct eventcount_s {
+  unsigned epoch;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} eventcount_t;
+
+static inline int eventcount_init(eventcount_t *ec) {
+  ec->epoch = 0;
+  if (pthread_mutex_init(&ec->mutex, NULL) == 0) {
+    if (pthread_cond_init(&ec->cond, NULL) == 0)
+      return 0;
+    pthread_mutex_destroy(&ec->mutex);
+  }
+  return -1;
+}
+
+static inline void eventcount_destroy(eventcount_t *ec) {
+  pthread_cond_destroy(&ec->cond);
+  pthread_mutex_destroy(&ec->mutex);
+}
+
+static inline unsigned eventcount_prepare_wait(eventcount_t *ec) {
+  pthread_mutex_lock(&ec->mutex);
+  unsigned key = ec->epoch;
+  pthread_mutex_unlock(&ec->mutex);
+  return key;
+}
+
+static inline void eventcount_cancel_wait(eventcount_t *ec) { (void)ec; }
+
+static inline void eventcount_wait_timeout(eventcount_t *ec, unsigned key, long long timeout_ns) {
+  struct timespec abstime;
+  if (timeout_ns >= 0) {
+    clock_gettime(CLOCK_REALTIME, &abstime);
+    abstime.tv_sec += timeout_ns / 1000000000;
+    abstime.tv_nsec += timeout_ns % 1000000000;
+    if (abstime.tv_nsec >= 1000000000) {
+      abstime.tv_sec++;
+      abstime.tv_nsec -= 1000000000;
+    }
+  }
+  pthread_mutex_lock(&ec->mutex);
+  while (ec->epoch == key) {
+    if (timeout_ns < 0)
+      pthread_cond_wait(&ec->cond, &ec->mutex);
+    else if (pthread_cond_timedwait(&ec->cond, &ec->mutex, &abstime) != 0)
+      break;
+  }
+  pthread_mutex_unlock(&ec->mutex);
+}
+
+static inline void eventcount_wait(eventcount_t *ec, unsigned key) {
+  eventcount_wait_timeout(ec, key, -1);
+}
+
+static inline void eventcount_notify(eventcount_t *ec, int all) {
+  pthread_mutex_lock(&ec->mutex);
+  ec->epoch++;
+  pthread_mutex_unlock(&ec->mutex);
+  if (all)
+    pthread_cond_broadcast(&ec->cond);
+  else
+    pthread_cond_signal(&ec->cond);
+}
+
+#endif // USE_PTHREAD_COND
+
+#endif
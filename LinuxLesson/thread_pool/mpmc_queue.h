@@ -0,0 +1,116 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "atomic.h"
+
+#ifdef __STDC_NO_ATOMICS__
+#error "mpmc_queue.h requires C11 atomics"
+#endif
+
+/**
+ * 有界无锁多生产者多消费者队列（Dmitry Vyukov 算法）
+ * 每个槽位带一个序号，pos 为生产者/消费者通过 CAS 领取到的位置：
+ *   seq == pos           槽位空闲，领取到 pos 的生产者可以写入
+ *   seq == pos + 1       槽位已写入，领取到 pos 的消费者可以读取
+ *   读取后 seq = pos + 容量，留给下一圈的生产者
+ * 生产者只竞争 enqueue_pos，消费者只竞争 dequeue_pos，没有全局锁；
+ * 两个位置计数器相隔一整条缓存行，避免生产者与消费者互相踩缓存行
+ */
+
+#define MPMC_CACHELINE 64
+
+typedef struct mpmc_cell_s {
+  ATOM_SIZET seq;
+  void *data;
+} mpmc_cell_t;
+
+typedef struct mpmc_queue_s {
+  mpmc_cell_t *buffer;
+  size_t mask;
+  char pad0[MPMC_CACHELINE];
+  ATOM_SIZET enqueue_pos;
+  char pad1[MPMC_CACHELINE];
+  ATOM_SIZET dequeue_pos;
+  char pad2[MPMC_CACHELINE];
+} mpmc_queue_t;
+
+// capacity 向上取整为 2 的幂；成功返回 0
+static inline int mpmc_queue_init(mpmc_queue_t *q, size_t capacity) {
+  size_t cap = 2;
+  while (cap < capacity)
+    cap <<= 1;
+  q->buffer = (mpmc_cell_t *)malloc(sizeof(mpmc_cell_t) * cap);
+  if (!q->buffer)
+    return -1;
+  size_t i;
+  for (i = 0; i < cap; i++) {
+    STD_ atomic_init(&q->buffer[i].seq, i);
+    q->buffer[i].data = NULL;
+  }
+  q->mask = cap - 1;
+  STD_ atomic_init(&q->enqueue_pos, (size_t)0);
+  STD_ atomic_init(&q->dequeue_pos, (size_t)0);
+  return 0;
+}
+
+static inline void mpmc_queue_destroy(mpmc_queue_t *q) {
+  free(q->buffer);
+  q->buffer = NULL;
+}
+
+// 入队；队列满返回 -1
+static inline int mpmc_queue_push(mpmc_queue_t *q, void *data) {
+  mpmc_cell_t *cell;
+  size_t pos = STD_ atomic_load_explicit(&q->enqueue_pos, STD_ memory_order_relaxed);
+  for (;;) {
+    cell = &q->buffer[pos & q->mask];
+    size_t seq = STD_ atomic_load_explicit(&cell->seq, STD_ memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      // 槽位空闲，领取该位置
+      if (STD_ atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                     STD_ memory_order_relaxed,
+                                                     STD_ memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      // 槽位仍被上一圈占用：队列满
+      return -1;
+    } else {
+      pos = STD_ atomic_load_explicit(&q->enqueue_pos, STD_ memory_order_relaxed);
+    }
+  }
+  cell->data = data;
+  STD_ atomic_store_explicit(&cell->seq, pos + 1, STD_ memory_order_release);
+  return 0;
+}
+
+// 出队；队列空返回 NULL
+static inline void *mpmc_queue_pop(mpmc_queue_t *q) {
+  mpmc_cell_t *cell;
+  size_t pos = STD_ atomic_load_explicit(&q->dequeue_pos, STD_ memory_order_relaxed);
+  for (;;) {
+    cell = &q->buffer[pos & q->mask];
+    size_t seq = STD_ atomic_load_explicit(&cell->seq, STD_ memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (diff == 0) {
+      if (STD_ atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1,
+                                                     STD_ memory_order_relaxed,
+                                                     STD_ memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      // 槽位尚未写入：队列空
+      return NULL;
+    } else {
+      pos = STD_ atomic_load_explicit(&q->dequeue_pos, STD_ memory_order_relaxed);
+    }
+  }
+  void *data = cell->data;
+  STD_ atomic_store_explicit(&cell->seq, pos + q->mask + 1, STD_ memory_order_release);
+  return data;
+}
+
+#endif
@@ -6,6 +6,28 @@
 #define SPIN_UNLOCK(q) spinlock_unlock(&(q)->lock);
 #define SPIN_DESTROY(q) spinlock_destroy(&(q)->lock);
 
+/**
+ * 编译时定义 SPINLOCK_STATS 打开统计（仅 C11 原子版本）：
+ * 每把锁记录获取次数、发生竞争的次数、等锁的 pause/yield 次数与最长持有时间，
+ * 统计字段只由持锁者写入，spinlock_get_stats/spinlock_dump_stats 可随时读取
+ */
+#if defined(SPINLOCK_STATS) &&                                                 \
+    (defined(USE_PTHREAD_LOCK) || defined(__STDC_NO_ATOMICS__) ||              \
+     defined(USE_TICKET_LOCK) || defined(USE_CLH_LOCK))
+#error "SPINLOCK_STATS requires the C11 atomic test-and-set spinlock"
+#endif
+
+/**
+ * 编译时选择锁的实现（接口不变）：
+ *   默认               test-and-test-and-set，无竞争时最快，但不公平，等锁者多时缓存行风暴
+ *   USE_TICKET_LOCK    票号锁：先到先得，所有等待者仍轮询同一缓存行
+ *   USE_CLH_LOCK       CLH 队列锁：先到先得，每个等待者只轮询前驱的节点
+ *   USE_PTHREAD_LOCK   pthread_mutex
+ */
+#if defined(USE_TICKET_LOCK) && defined(USE_CLH_LOCK)
+#error "USE_TICKET_LOCK and USE_CLH_LOCK are mutually exclusive"
+#endif
+
 #ifndef USE_PTHREAD_LOCK
 
 #ifdef __STDC_NO_ATOMICS__
@@ -41,6 +63,8 @@ static inline void spinlock_destroy(struct spinlock *lock) { (void)lock; }
 
 #else // __STDC_NO_ATOMICS__
 
+#include <sched.h>
+
 #include "atomic.h"
 
 #define atomic_test_and_set_(ptr)                                              \
@@ -57,34 +81,338 @@ static inline void spinlock_destroy(struct spinlock *lock) { (void)lock; }
 #define atomic_pause_() ((void)0)
 #endif
 
+// 等锁时 pause 次数按 1,2,4..SPINLOCK_BACKOFF_MAX 指数退避，
+// 累计超过 SPINLOCK_SPIN_LIMIT 后改为 sched_yield，超售时把 CPU 让给持锁者
+#ifndef SPINLOCK_SPIN_LIMIT
+#define SPINLOCK_SPIN_LIMIT 4096
+#endif
+#ifndef SPINLOCK_BACKOFF_MAX
+#define SPINLOCK_BACKOFF_MAX 64
+#endif
+
+#if defined(USE_TICKET_LOCK)
+
+struct spinlock {
+  STD_ atomic_uint next;  // 下一个发放的票号
+  STD_ atomic_uint owner; // 正在服务的票号
+};
+
+static inline void spinlock_init(struct spinlock *lock) {
+  STD_ atomic_init(&lock->next, 0u);
+  STD_ atomic_init(&lock->owner, 0u);
+}
+
+static inline void spinlock_lock(struct spinlock *lock) {
+  unsigned ticket = STD_ atomic_fetch_add_explicit(&lock->next, 1u, STD_ memory_order_relaxed);
+  unsigned long long spins = 0;
+  unsigned owner, i;
+  while ((owner = STD_ atomic_load_explicit(&lock->owner, STD_ memory_order_acquire)) != ticket) {
+    if (spins < SPINLOCK_SPIN_LIMIT) {
+      // 按前面排队的人数退避，减少对 owner 缓存行的轮询
+      unsigned ahead = ticket - owner;
+      unsigned pauses = ahead < SPINLOCK_BACKOFF_MAX ? ahead : SPINLOCK_BACKOFF_MAX;
+      for (i = 0; i < pauses; i++)
+        atomic_pause_();
+      spins += pauses;
+    } else {
+      sched_yield();
+    }
+  }
+}
+
+static inline int spinlock_trylock(struct spinlock *lock) {
+  // acquire：与上一个持锁者 unlock 的 release 配对
+  unsigned owner = STD_ atomic_load_explicit(&lock->owner, STD_ memory_order_acquire);
+  unsigned next = owner;
+  // 没有人持锁或排队时 next == owner，抢占下一个票号即获得锁
+  return STD_ atomic_compare_exchange_strong_explicit(&lock->next, &next, owner + 1,
+                                                      STD_ memory_order_acquire,
+                                                      STD_ memory_order_relaxed);
+}
+
+static inline void spinlock_unlock(struct spinlock *lock) {
+  unsigned owner = STD_ atomic_load_explicit(&lock->owner, STD_ memory_order_relaxed);
+  STD_ atomic_store_explicit(&lock->owner, owner + 1, STD_ memory_order_release);
+}
+
+static inline void spinlock_destroy(struct spinlock *lock) { (void)lock; }
+
+#elif defined(USE_CLH_LOCK)
+
+#include <pthread.h>
+#include <stdlib.h>
+
+// CLH：tail 指向最后一个排队者的节点，新来者交换 tail 后只轮询前驱节点的 locked。
+// 释放后前驱节点归自己所有，下一次加锁复用，所以每个线程只持有一个节点，
+// 且同一线程可以嵌套持有多把不同的锁
+typedef struct clh_node_s {
+  STD_ atomic_int locked;
+  struct clh_node_s *free_next; // 在空闲链表里时使用
+  char pad[64 - sizeof(STD_ atomic_int) - sizeof(void *)];
+} clh_node_t;
+
+struct spinlock {
+  STD_ atomic_uintptr_t tail;
+  clh_node_t *owner; // 持锁者的节点，只由持锁者读写
+};
+
+static __thread clh_node_t *clh_my_node_;
+static pthread_key_t clh_key_;
+static pthread_once_t clh_once_ = PTHREAD_ONCE_INIT;
+
+// 节点从不还给 malloc：trylock 读到的 tail 可能随即被出队、归还，
+// 它仍会去读这个节点的 locked，所以节点只在空闲链表里循环使用
+static clh_node_t *clh_free_;
+static pthread_mutex_t clh_free_lock_ = PTHREAD_MUTEX_INITIALIZER;
+
+static inline clh_node_t *clh_node_new_(void) {
+  pthread_mutex_lock(&clh_free_lock_);
+  clh_node_t *node = clh_free_;
+  if (node)
+    clh_free_ = node->free_next;
+  pthread_mutex_unlock(&clh_free_lock_);
+  if (!node) {
+    if (posix_memalign((void **)&node, 64, sizeof(clh_node_t)) != 0)
+      abort();
+    STD_ atomic_init(&node->locked, 0);
+  } else {
+    STD_ atomic_store_explicit(&node->locked, 0, STD_ memory_order_relaxed);
+  }
+  return node;
+}
+
+static inline void clh_node_free_(clh_node_t *node) {
+  pthread_mutex_lock(&clh_free_lock_);
+  node->free_next = clh_free_;
+  clh_free_ = node;
+  pthread_mutex_unlock(&clh_free_lock_);
+}
+
+// 线程退出时归还手上的节点：它是某次加锁得到的前驱，已不在任何队列里
+static inline void clh_node_release_(void *slot) {
+  clh_node_free_(*(clh_node_t **)slot);
+  *(clh_node_t **)slot = NULL;
+}
+
+static inline void clh_key_create_(void) {
+  pthread_key_create(&clh_key_, clh_node_release_);
+}
+
+static inline clh_node_t *clh_my_node_get_(void) {
+  if (!clh_my_node_) {
+    pthread_once(&clh_once_, clh_key_create_);
+    clh_my_node_ = clh_node_new_();
+    pthread_setspecific(clh_key_, &clh_my_node_);
+  }
+  return clh_my_node_;
+}
+
+static inline void spinlock_init(struct spinlock *lock) {
+  STD_ atomic_init(&lock->tail, (uintptr_t)clh_node_new_());
+  lock->owner = NULL;
+}
+
+static inline void spinlock_lock(struct spinlock *lock) {
+  clh_node_t *node = clh_my_node_get_();
+  STD_ atomic_store_explicit(&node->locked, 1, STD_ memory_order_relaxed);
+  clh_node_t *pred = (clh_node_t *)STD_ atomic_exchange_explicit(
+      &lock->tail, (uintptr_t)node, STD_ memory_order_acq_rel);
+  unsigned long long spins = 0;
+  unsigned backoff = 1, i;
+  while (STD_ atomic_load_explicit(&pred->locked, STD_ memory_order_acquire)) {
+    if (spins < SPINLOCK_SPIN_LIMIT) {
+      for (i = 0; i < backoff; i++)
+        atomic_pause_();
+      spins += backoff;
+      if (backoff < SPINLOCK_BACKOFF_MAX)
+        backoff <<= 1;
+    } else {
+      sched_yield();
+    }
+  }
+  lock->owner = node;
+  clh_my_node_ = pred;
+}
+
+static inline int spinlock_trylock(struct spinlock *lock) {
+  clh_node_t *node = clh_my_node_get_();
+  uintptr_t tail = STD_ atomic_load_explicit(&lock->tail, STD_ memory_order_acquire);
+  clh_node_t *pred = (clh_node_t *)tail;
+  if (STD_ atomic_load_explicit(&pred->locked, STD_ memory_order_acquire))
+    return 0;
+  STD_ atomic_store_explicit(&node->locked, 1, STD_ memory_order_relaxed);
+  if (!STD_ atomic_compare_exchange_strong_explicit(&lock->tail, &tail, (uintptr_t)node,
+                                                    STD_ memory_order_acq_rel,
+                                                    STD_ memory_order_relaxed))
+    return 0;
+  // CAS 成功就已经入队，不能再退出。读 locked 到 CAS 之间 pred 可能被释放、
+  // 又被别的线程当作自己的节点重新入队（ABA），此时 pred 的主人可能正持锁或在排队，
+  // 必须像 spinlock_lock 一样等前驱释放
+  unsigned long long spins = 0;
+  while (STD_ atomic_load_explicit(&pred->locked, STD_ memory_order_acquire)) {
+    if (spins++ < SPINLOCK_SPIN_LIMIT)
+      atomic_pause_();
+    else
+      sched_yield();
+  }
+  lock->owner = node;
+  clh_my_node_ = pred;
+  return 1;
+}
+
+static inline void spinlock_unlock(struct spinlock *lock) {
+  clh_node_t *node = lock->owner;
+  STD_ atomic_store_explicit(&node->locked, 0, STD_ memory_order_release);
+}
+
+// 销毁时 tail 节点已释放且不属于任何线程
+static inline void spinlock_destroy(struct spinlock *lock) {
+  clh_node_free_((clh_node_t *)STD_ atomic_load(&lock->tail));
+}
+
+#else // test-and-test-and-set
+
+#ifdef SPINLOCK_STATS
+
+#include <stdio.h>
+#include <time.h>
+
+typedef struct spinlock_stats_s {
+  unsigned long long acquisitions; // 成功获取次数（含 trylock）
+  unsigned long long contended;    // 首次尝试失败、需要等待的次数
+  unsigned long long spins;        // 等锁期间的 pause 次数
+  unsigned long long yields;       // 等锁期间的 sched_yield 次数
+  unsigned long long max_hold_ns;  // 最长持有时间
+} spinlock_stats_t;
+
+#define atomic_add_relaxed_(ptr, v)                                            \
+  STD_ atomic_store_explicit(ptr, atomic_load_relaxed_(ptr) + (v),             \
+                             STD_ memory_order_relaxed)
+
+#endif // SPINLOCK_STATS
+
 struct spinlock {
   STD_ atomic_int lock;
+#ifdef SPINLOCK_STATS
+  // 只由持锁者写，读者用 relaxed 读取近似快照
+  STD_ atomic_ullong acquisitions;
+  STD_ atomic_ullong contended;
+  STD_ atomic_ullong spins;
+  STD_ atomic_ullong yields;
+  STD_ atomic_ullong max_hold_ns;
+  unsigned long long hold_start;
+#endif
 };
 
+#ifdef SPINLOCK_STATS
+
+static inline unsigned long long spinlock_now_ns_(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline void spinlock_acquired_(struct spinlock *lock, int contended,
+                                      unsigned long long spins,
+                                      unsigned long long yields) {
+  atomic_add_relaxed_(&lock->acquisitions, 1);
+  if (contended) {
+    atomic_add_relaxed_(&lock->contended, 1);
+    atomic_add_relaxed_(&lock->spins, spins);
+    atomic_add_relaxed_(&lock->yields, yields);
+  }
+  lock->hold_start = spinlock_now_ns_();
+}
+
+static inline void spinlock_released_(struct spinlock *lock) {
+  unsigned long long hold = spinlock_now_ns_() - lock->hold_start;
+  if (hold > atomic_load_relaxed_(&lock->max_hold_ns))
+    STD_ atomic_store_explicit(&lock->max_hold_ns, hold, STD_ memory_order_relaxed);
+}
+
+static inline void spinlock_get_stats(struct spinlock *lock, spinlock_stats_t *stats) {
+  stats->acquisitions = atomic_load_relaxed_(&lock->acquisitions);
+  stats->contended = atomic_load_relaxed_(&lock->contended);
+  stats->spins = atomic_load_relaxed_(&lock->spins);
+  stats->yields = atomic_load_relaxed_(&lock->yields);
+  stats->max_hold_ns = atomic_load_relaxed_(&lock->max_hold_ns);
+}
+
+static inline void spinlock_dump_stats(struct spinlock *lock, const char *name, FILE *fp) {
+  spinlock_stats_t st;
+  spinlock_get_stats(lock, &st);
+  fprintf(fp,
+          "spinlock %s: acquisitions=%llu contended=%llu (%.2f%%) spins=%llu "
+          "yields=%llu max_hold=%lluns\n",
+          name ? name : "?", st.acquisitions, st.contended,
+          st.acquisitions ? 100.0 * st.contended / st.acquisitions : 0.0,
+          st.spins, st.yields, st.max_hold_ns);
+}
+
+#endif // SPINLOCK_STATS
+
 static inline void spinlock_init(struct spinlock *lock) {
   STD_ atomic_init(&lock->lock, 0);
+#ifdef SPINLOCK_STATS
+  STD_ atomic_init(&lock->acquisitions, 0ull);
+  STD_ atomic_init(&lock->contended, 0ull);
+  STD_ atomic_init(&lock->spins, 0ull);
+  STD_ atomic_init(&lock->yields, 0ull);
+  STD_ atomic_init(&lock->max_hold_ns, 0ull);
+  lock->hold_start = 0;
+#endif
 }
 
 static inline void spinlock_lock(struct spinlock *lock) {
+  unsigned long long spins = 0, yields = 0;
+  unsigned backoff = 1, i;
+  int contended = 0;
   for (;;) {
     if (!atomic_test_and_set_(&lock->lock))
-      return;
-    while (atomic_load_relaxed_(&lock->lock))
-      atomic_pause_();
+      break;
+    contended = 1;
+    while (atomic_load_relaxed_(&lock->lock)) {
+      if (spins < SPINLOCK_SPIN_LIMIT) {
+        for (i = 0; i < backoff; i++)
+          atomic_pause_();
+        spins += backoff;
+        if (backoff < SPINLOCK_BACKOFF_MAX)
+          backoff <<= 1;
+      } else {
+        sched_yield();
+        yields++;
+      }
+    }
   }
+#ifdef SPINLOCK_STATS
+  spinlock_acquired_(lock, contended, spins, yields);
+#else
+  (void)contended;
+  (void)yields;
+#endif
 }
 
 static inline int spinlock_trylock(struct spinlock *lock) {
-  return !atomic_load_relaxed_(&lock->lock) &&
-         !atomic_test_and_set_(&lock->lock);
+  int ok = !atomic_load_relaxed_(&lock->lock) &&
+           !atomic_test_and_set_(&lock->lock);
+#ifdef SPINLOCK_STATS
+  if (ok)
+    spinlock_acquired_(lock, 0, 0, 0);
+#endif
+  return ok;
 }
 
 static inline void spinlock_unlock(struct spinlock *lock) {
+#ifdef SPINLOCK_STATS
+  spinlock_released_(lock);
+#endif
   atomic_clear_(&lock->lock);
 }
 
 static inline void spinlock_destroy(struct spinlock *lock) { (void)lock; }
 
+#endif // USE_TICKET_LOCK / USE_CLH_LOCK
+
 #endif // __STDC_NO_ATOMICS__
 
 #else
@@ -0,0 +1,100 @@
+#include "spinlock.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/**
+ * 自旋锁微基准：2~64 个线程在同一把锁上做短临界区，统计吞吐与公平性
+ * 锁的实现在编译期选择，每个变体单独编译一次：
+ * shell: g++ -O2 spinlock_bench.cc -o spinlock_bench_tas -lpthread
+ * shell: g++ -O2 -DUSE_TICKET_LOCK spinlock_bench.cc -o spinlock_bench_ticket -lpthread
+ * shell: g++ -O2 -DUSE_CLH_LOCK spinlock_bench.cc -o spinlock_bench_clh -lpthread
+ * shell: g++ -O2 -DUSE_PTHREAD_LOCK spinlock_bench.cc -o spinlock_bench_mutex -lpthread
+ * usage: ./spinlock_bench_tas [每轮毫秒数，默认 200]
+ */
+
+#if defined(USE_PTHREAD_LOCK)
+static const char *kLockName = "mutex";
+#elif defined(USE_TICKET_LOCK)
+static const char *kLockName = "ticket";
+#elif defined(USE_CLH_LOCK)
+static const char *kLockName = "clh";
+#else
+static const char *kLockName = "tas";
+#endif
+
+struct alignas(64) Counter {
+    int64_t ops = 0;
+};
+
+// 模拟任务队列的临界区与临界区外的少量工作
+static inline void Work(int n) {
+    for (int i = 0; i < n; ++i) {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+}
+
+void bench(int nthread, int ms) {
+    struct spinlock lock;
+    spinlock_init(&lock);
+    int64_t shared = 0;
+    std::atomic<bool> start{false}, stop{false};
+    std::vector<Counter> counters(nthread);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < nthread; ++t) {
+        threads.emplace_back([&, t] {
+            while (!start.load()) {
+                std::this_thread::yield();
+            }
+            int64_t ops = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                spinlock_lock(&lock);
+                ++shared;
+                Work(20);
+                spinlock_unlock(&lock);
+                Work(50);
+                ++ops;
+            }
+            counters[t].ops = ops;
+        });
+    }
+
+    start = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    stop = true;
+    for (auto &t : threads) {
+        t.join();
+    }
+    spinlock_destroy(&lock);
+
+    // 公平性：各线程获取次数的最小/最大比值与 Jain 指数（1 为完全公平）
+    int64_t total = 0, mn = INT64_MAX, mx = 0;
+    double sq = 0;
+    for (auto &c : counters) {
+        total += c.ops;
+        mn = std::min(mn, c.ops);
+        mx = std::max(mx, c.ops);
+        sq += (double)c.ops * c.ops;
+    }
+    double jain = sq > 0 ? (double)total * total / (nthread * sq) : 0;
+
+    std::cout << kLockName << " threads:" << nthread
+        << " ops per sec:" << (double)total * 1000 / ms
+        << " min/max:" << (mx ? (double)mn / mx : 0)
+        << " jain:" << jain
+        << (shared == total ? "" : " MISMATCH") << std::endl;
+}
+
+int main(int argc, char **argv) {
+    int ms = argc > 1 ? std::atoi(argv[1]) : 200;
+    for (int nthread : {2, 4, 8, 16, 32, 64}) {
+        bench(nthread, ms);
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "spinlock.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+/**
+ * 自旋锁正确性测试：多线程混用 lock / trylock 争同一把锁，检查互斥与计数
+ * 锁的实现在编译期选择，每个变体单独编译一次：
+ * shell: g++ -O2 spinlock_test.cc -o spinlock_test_tas -lgtest -lgtest_main -lpthread
+ * shell: g++ -O2 -DUSE_TICKET_LOCK spinlock_test.cc -o spinlock_test_ticket -lgtest -lgtest_main -lpthread
+ * shell: g++ -O2 -DUSE_CLH_LOCK spinlock_test.cc -o spinlock_test_clh -lgtest -lgtest_main -lpthread
+ * 统计只有 test-and-set 版本支持：
+ * shell: g++ -O2 -DSPINLOCK_STATS spinlock_test.cc -o spinlock_test_stats -lgtest -lgtest_main -lpthread
+ */
+
+// 临界区内非原子地读改写，配合 inside 检查是否有两个线程同时持锁
+static void critical(long *counter, volatile int *inside) {
+  ASSERT_EQ(*inside, 0);
+  *inside = 1;
+  long v = *counter;
+  *counter = v + 1;
+  *inside = 0;
+}
+
+TEST(spinlock, lock_trylock) {
+  struct spinlock lock;
+  spinlock_init(&lock);
+  const int nthread = 4, loops = 200000;
+  long counter = 0, tried = 0;
+  volatile int inside = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nthread; t++) {
+    threads.emplace_back([&, t] {
+      long mine = 0;
+      for (int i = 0; i < loops; i++) {
+        // 一半线程只用 trylock 抢，失败就重试
+        if (t & 1) {
+          while (!spinlock_trylock(&lock))
+            std::this_thread::yield();
+          critical(&counter, &inside);
+          mine++;
+        } else {
+          spinlock_lock(&lock);
+          critical(&counter, &inside);
+        }
+        spinlock_unlock(&lock);
+      }
+      spinlock_lock(&lock);
+      tried += mine;
+      spinlock_unlock(&lock);
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+  ASSERT_EQ(counter, (long)nthread * loops);
+  ASSERT_EQ(tried, (long)(nthread / 2) * loops);
+  spinlock_destroy(&lock);
+}
+
+TEST(spinlock, trylock_held) {
+  struct spinlock lock;
+  spinlock_init(&lock);
+  ASSERT_TRUE(spinlock_trylock(&lock));
+  // 持锁期间别的线程 trylock 必然失败
+  bool got = true;
+  std::thread([&] { got = spinlock_trylock(&lock); }).join();
+  ASSERT_FALSE(got);
+  spinlock_unlock(&lock);
+  std::thread([&] {
+    got = spinlock_trylock(&lock);
+    if (got)
+      spinlock_unlock(&lock);
+  }).join();
+  ASSERT_TRUE(got);
+  spinlock_destroy(&lock);
+}
+
+#ifdef SPINLOCK_STATS
+
+TEST(spinlock, stats) {
+  struct spinlock lock;
+  spinlock_init(&lock);
+  const int nthread = 4, loops = 100000;
+  long counter = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nthread; t++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < loops; i++) {
+        spinlock_lock(&lock);
+        counter++;
+        spinlock_unlock(&lock);
+      }
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+  ASSERT_TRUE(spinlock_trylock(&lock));
+  spinlock_unlock(&lock);
+
+  spinlock_stats_t st;
+  spinlock_get_stats(&lock, &st);
+  ASSERT_EQ(counter, (long)nthread * loops);
+  ASSERT_EQ(st.acquisitions, (unsigned long long)nthread * loops + 1);
+  ASSERT_LE(st.contended, st.acquisitions);
+  // 有竞争就必然有等待
+  ASSERT_TRUE(st.contended == 0 || st.spins + st.yields > 0);
+  ASSERT_GT(st.max_hold_ns, 0ull);
+  spinlock_dump_stats(&lock, "test", stdout);
+  spinlock_destroy(&lock);
+}
+
+#endif // SPINLOCK_STATS
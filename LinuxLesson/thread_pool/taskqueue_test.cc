@@ -1,6 +1,9 @@
 #include <pthread.h>
 #include "spinlock.h"
+#include "mpmc_queue.h"
 #include <gtest/gtest.h>
+#include <thread>
+#include <vector>
 
 /**
  * shell: g++ taskqueue_test.cc -o taskqueue_test -lgtest -lgtest_main -lpthread
@@ -137,3 +140,57 @@ TEST(task_queue, normal) {
   }
   ASSERT_TRUE(i == 10);
 }
+
+TEST(mpmc_queue, full_and_wrap) {
+  mpmc_queue_t q;
+  ASSERT_EQ(mpmc_queue_init(&q, 5), 0); // 取整为 8
+  long i;
+  for (int round = 0; round < 3; round++) {
+    for (i = 0; i < 8; i++)
+      ASSERT_EQ(mpmc_queue_push(&q, (void *)(i + 1)), 0);
+    ASSERT_EQ(mpmc_queue_push(&q, (void *)100), -1);
+    for (i = 0; i < 8; i++)
+      ASSERT_EQ(mpmc_queue_pop(&q), (void *)(i + 1));
+    ASSERT_EQ(mpmc_queue_pop(&q), (void *)NULL);
+  }
+  mpmc_queue_destroy(&q);
+}
+
+TEST(mpmc_queue, concurrent) {
+  const int nproducer = 4, nconsumer = 4;
+  const long per_producer = 100000;
+  mpmc_queue_t q;
+  ASSERT_EQ(mpmc_queue_init(&q, 256), 0);
+
+  std::atomic<long> popped{0};
+  std::atomic<long> sum{0};
+  std::vector<std::thread> threads;
+  for (int p = 0; p < nproducer; p++) {
+    threads.emplace_back([&q, per_producer] {
+      for (long i = 1; i <= per_producer; i++)
+        while (mpmc_queue_push(&q, (void *)i) != 0)
+          std::this_thread::yield();
+    });
+  }
+  for (int c = 0; c < nconsumer; c++) {
+    threads.emplace_back([&] {
+      while (popped.load() < nproducer * per_producer) {
+        void *data = mpmc_queue_pop(&q);
+        if (!data) {
+          std::this_thread::yield();
+          continue;
+        }
+        sum += (long)data;
+        ++popped;
+      }
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+
+  // 每个元素恰好被取出一次
+  ASSERT_EQ(popped.load(), nproducer * per_producer);
+  ASSERT_EQ(sum.load(), nproducer * per_producer * (per_producer + 1) / 2);
+  ASSERT_EQ(mpmc_queue_pop(&q), (void *)NULL);
+  mpmc_queue_destroy(&q);
+}
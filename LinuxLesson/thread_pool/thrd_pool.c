@@ -1,12 +1,17 @@
 #include <pthread.h>
+#include <sched.h>
 #include <stdatomic.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <time.h>
 #include "thrd_pool.h"
 #include "spinlock.h"
+#include "mpmc_queue.h"
+#include "eventcount.h"
 
 /**
  * shell: gcc thrd_pool.c -c -fPIC
+ * shell: gcc thrd_pool.c -c -fPIC -DSPINLOCK_STATS   # 统计任务队列锁竞争
  * shell: gcc -shared thrd_pool.o -o libthrd_pool.so -I./ -L./ -lpthread
  * usage: include thrd_pool.h & link libthrd_pool.so
  */
@@ -20,39 +25,222 @@ typedef struct task_s {
 } task_t;
 
 typedef struct task_queue_s {
-  void *head;
-  void **tail;
-  int block;
+  void *head[THRDPOOL_PRIO_LEVELS]; // 每个优先级一条链表，高优先级先出队
+  void **tail[THRDPOOL_PRIO_LEVELS];
+  atomic_int block;
+  atomic_int count; // 各链表任务数之和，在 lock 内修改；无锁模式下在锁外读取以跳过空链表
+  int pop_batch;  // 每次 __pop_task 最多取走的任务数
+  atomic_int consumers; // 在岗工作线程数：按份额批量取任务，编号不小于它的线程退出
+  thrdpool_queue_mode_t mode;
+  mpmc_queue_t *ring; // 无锁模式下替代 head/tail 链表
   spinlock_t lock;
-  pthread_mutex_t mutex;
-  pthread_cond_t cond;
+  eventcount_t ec; // 工作线程休眠；没有线程休眠时 post 不进入内核
 } task_queue_t;
 
+// 任务节点缓存
+// 每个线程一份本地缓存：post 从 alloc_list 取节点，执行完的节点挂到 free 链表，
+// 攒满 TASK_CACHE_BATCH 个后整批压入全局无锁栈；本地取空时一次摘走整个全局栈。
+// 生产者与消费者不同线程时，节点在两者之间整批流转，稳态下不再进入 malloc/free。
+// 全局栈压入用 CAS、取出用 exchange 摘走整栈，不存在逐个弹出的 ABA 问题。
+// 节点按批 malloc，进程存活期间只在缓存中循环，不归还给 malloc
+#define TASK_CACHE_BATCH 64
+
+typedef struct task_cache_s {
+  task_t *alloc_list; // 供本线程 post 使用
+  task_t *free_head;  // 本线程回收、尚未归还全局栈的节点
+  task_t *free_tail;
+  int free_count;
+  int registered;     // 已登记线程退出回调
+} task_cache_t;
+
+static _Atomic(task_t *) g_task_stack = NULL;
+static __thread task_cache_t t_task_cache;
+static pthread_key_t g_task_cache_key;
+static pthread_once_t g_task_cache_once = PTHREAD_ONCE_INIT;
+
+// 把 [head, tail] 整条链压入全局栈
+static void __task_stack_push(task_t *head, task_t *tail) {
+  task_t *top = atomic_load_explicit(&g_task_stack, memory_order_relaxed);
+  do {
+    tail->next = top;
+  } while (!atomic_compare_exchange_weak_explicit(
+      &g_task_stack, &top, head, memory_order_release, memory_order_relaxed));
+}
+
+// 线程退出时把本地缓存的节点还给全局栈
+static void __task_cache_flush(void *arg) {
+  task_cache_t *cache = (task_cache_t *)arg;
+  if (cache->free_head) {
+    __task_stack_push(cache->free_head, cache->free_tail);
+    cache->free_head = cache->free_tail = NULL;
+    cache->free_count = 0;
+  }
+  if (cache->alloc_list) {
+    task_t *tail = cache->alloc_list;
+    while (tail->next)
+      tail = (task_t *)tail->next;
+    __task_stack_push(cache->alloc_list, tail);
+    cache->alloc_list = NULL;
+  }
+}
+
+static void __task_cache_key_create(void) {
+  pthread_key_create(&g_task_cache_key, __task_cache_flush);
+}
+
+static task_cache_t *__task_cache(void) {
+  task_cache_t *cache = &t_task_cache;
+  if (!cache->registered) {
+    pthread_once(&g_task_cache_once, __task_cache_key_create);
+    pthread_setspecific(g_task_cache_key, cache);
+    cache->registered = 1;
+  }
+  return cache;
+}
+
+static task_t *__task_alloc(void) {
+  task_cache_t *cache = __task_cache();
+  task_t *task = cache->alloc_list;
+  if (!task) {
+    if (cache->free_head) {
+      // 本线程刚回收的节点（在任务里 post 的场景）
+      task = cache->free_head;
+      cache->free_head = cache->free_tail = NULL;
+      cache->free_count = 0;
+    } else {
+      task = atomic_exchange_explicit(&g_task_stack, NULL, memory_order_acquire);
+    }
+    if (!task) {
+      task = (task_t *)malloc(sizeof(task_t) * TASK_CACHE_BATCH);
+      if (!task)
+        return NULL;
+      int i;
+      for (i = 0; i < TASK_CACHE_BATCH - 1; i++)
+        task[i].next = &task[i + 1];
+      task[TASK_CACHE_BATCH - 1].next = NULL;
+    }
+  }
+  cache->alloc_list = (task_t *)task->next;
+  return task;
+}
+
+static void __task_free(task_t *task) {
+  task_cache_t *cache = __task_cache();
+  task->next = cache->free_head;
+  cache->free_head = task;
+  if (!cache->free_tail)
+    cache->free_tail = task;
+  if (++cache->free_count == TASK_CACHE_BATCH) {
+    __task_stack_push(cache->free_head, cache->free_tail);
+    cache->free_head = cache->free_tail = NULL;
+    cache->free_count = 0;
+  }
+}
+
+// 延迟任务：按到期时间排列的最小堆
+typedef struct timer_entry_s {
+  uint64_t deadline; // CLOCK_MONOTONIC 纳秒
+  uint64_t seq;      // 同一到期时间按提交顺序
+  task_t *task;
+} timer_entry_t;
+
+typedef struct thrdpool_worker_s {
+  thrdpool_t *pool;
+  int id;
+  pthread_t thread;
+  void *local; // 私有存储，创建线程前取好，工作线程不访问会扩容的 storage 数组
+} thrdpool_worker_t;
+
+// 工作窃取模式下每个工作线程的本地队列，独占缓存行
+typedef struct local_queue_s {
+  spinlock_t lock;
+  void *head;
+  void **tail;
+  atomic_int count; // 在 lock 内修改，窃取者在锁外读取以跳过空队列
+} local_queue_t;
+
+static __thread thrdpool_worker_t *t_worker; // 当前线程所属的工作线程，非工作线程为 NULL
+static __thread thrdpool_t *t_home_pool;     // 外部线程上次提交的线程池
+static __thread unsigned t_home_slot;        // 外部线程在该线程池里分到的本地队列
+
 struct thrdpool_s {
   task_queue_t *task_queue;
-  atomic_int quit;
+  atomic_int quit;  // 不再接受新任务
+  atomic_int stop;  // 工作线程立即退出，不再执行队列中的任务
   int thrd_count;
-  pthread_t *threads;
+  int thrd_cap;
+  thrdpool_worker_t **workers;
+  pthread_mutex_t resize_mutex; // 串行化 resize 与 waitdone
+
+  // 已提交未执行完的任务数；归零时唤醒 thrdpool_wait_idle
+  atomic_long pending;
+  atomic_int idle_waiters;
+  pthread_mutex_t idle_mutex;
+  pthread_cond_t idle_cond;
+
+  // 延迟任务不单独起定时线程：工作线程在取任务前把到期的任务挪进队列，
+  // 全部空闲时由其中一个线程按堆顶到期时间限时休眠（timer_duty）
+  spinlock_t timer_lock;
+  timer_entry_t *timers;
+  int timer_count;
+  int timer_cap;
+  uint64_t timer_seq;
+  atomic_ullong next_deadline; // 堆顶到期时间，空堆为 UINT64_MAX
+  atomic_int timer_duty;
+
+  // 工作窃取模式：下标即工作线程编号。本地队列只增不减，扩容时换新数组，
+  // 旧数组留到销毁时释放，提交方无锁读取时不会访问到已释放的内存
+  _Atomic(local_queue_t **) locals;
+  atomic_int nlocals; // 已分配的本地队列数，窃取时扫描全部（含已裁撤线程的）
+  int locals_cap;
+  void **retired_locals;
+  int nretired_locals;
+  atomic_uint rr; // 外部提交的轮转游标
+
+  // 工作线程私有存储：下标即工作线程编号，只增不减，裁撤的线程留下的部分结果
+  // 仍可被 thrdpool_reduce 合并；只在 resize_mutex 内或创建时修改
+  void **storage;
+  int nstorage;
+  thrdpool_worker_init_pt worker_init;
+  thrdpool_worker_hook_pt worker_reset;
+  thrdpool_worker_hook_pt worker_fini;
+  void *worker_user;
 };
 
 // 对称
 // 资源的创建   回滚式编程
 // 业务逻辑     防御式编程
-static task_queue_t *__taskqueue_create() {
+static task_queue_t *__taskqueue_create(const thrdpool_attr_t *attr) {
   int ret;
   task_queue_t *queue = (task_queue_t *)malloc(sizeof(task_queue_t));
   if (queue) {
-    ret = pthread_mutex_init(&queue->mutex, NULL);
+    queue->mode = attr->queue_mode;
+    queue->ring = NULL;
+    if (queue->mode == THRDPOOL_QUEUE_LOCKFREE) {
+      queue->ring = (mpmc_queue_t *)malloc(sizeof(mpmc_queue_t));
+      if (!queue->ring || mpmc_queue_init(queue->ring, attr->queue_capacity) != 0) {
+        free(queue->ring);
+        free(queue);
+        return NULL;
+      }
+    }
+    ret = eventcount_init(&queue->ec);
     if (ret == 0) {
-      ret = pthread_cond_init(&queue->cond, NULL);
-      if (ret == 0) {
-        spinlock_init(&queue->lock);
-        queue->head = NULL;
-        queue->tail = &queue->head;
-        queue->block = 1;
-        return queue;
+      spinlock_init(&queue->lock);
+      int prio;
+      for (prio = 0; prio < THRDPOOL_PRIO_LEVELS; prio++) {
+        queue->head[prio] = NULL;
+        queue->tail[prio] = &queue->head[prio];
       }
-      pthread_mutex_destroy(&queue->mutex);
+      atomic_init(&queue->block, 1);
+      atomic_init(&queue->count, 0);
+      queue->pop_batch = attr->pop_batch > 0 ? attr->pop_batch : 1;
+      atomic_init(&queue->consumers, attr->thrd_count);
+      return queue;
+    }
+    if (queue->ring) {
+      mpmc_queue_destroy(queue->ring);
+      free(queue->ring);
     }
     free(queue);
   }
@@ -60,170 +248,919 @@ static task_queue_t *__taskqueue_create() {
 }
 
 static void __nonblock(task_queue_t *queue) {
-  pthread_mutex_lock(&queue->mutex);
-  queue->block = 0;
-  pthread_mutex_unlock(&queue->mutex);
-  pthread_cond_broadcast(&queue->cond);
+  atomic_store(&queue->block, 0);
+  eventcount_notify(&queue->ec, 1);
+}
+
+static inline void __wakeup(task_queue_t *queue, int n) {
+  eventcount_notify(&queue->ec, n > 1);
 }
 
-static inline void __add_task(task_queue_t *queue, void *task) {
+// 把调用方已串好的 [head, tail] 共 n 个任务一次挂到 prio 链表队尾，只加一次锁、唤醒一次
+static inline void __add_list(task_queue_t *queue, void *head, void *tail, int n, int prio) {
   // 不限定任务类型，只要该任务的结构起始内存是一个用于链接下一个节点的指针
-  void **link = (void **)task;
+  void **link = (void **)tail;
   *link = NULL;
 
   spinlock_lock(&queue->lock);
-  *queue->tail /* 等价于 queue->tail->next */ = link;
-  queue->tail = link;
+  *queue->tail[prio] /* 等价于 queue->tail->next */ = head;
+  queue->tail[prio] = link;
+  atomic_store_explicit(&queue->count,
+                        atomic_load_explicit(&queue->count, memory_order_relaxed) + n,
+                        memory_order_relaxed);
   spinlock_unlock(&queue->lock);
-  pthread_cond_signal(&queue->cond);
+  __wakeup(queue, n);
 }
 
-static inline void *__pop_task(task_queue_t *queue) {
+// 成功返回 0；无锁队列满时返回 -1，由调用方决定重试
+// 无锁模式下只有普通优先级进环形队列，其余优先级走链表
+static inline int __add_task(task_queue_t *queue, void *task, int prio) {
+  if (queue->mode == THRDPOOL_QUEUE_LOCKFREE && prio == THRDPOOL_PRIO_NORMAL) {
+    if (mpmc_queue_push(queue->ring, task) != 0)
+      return -1;
+    __wakeup(queue, 1);
+    return 0;
+  }
+  __add_list(queue, task, task, 1, prio);
+  return 0;
+}
+
+// 从 [from, to] 优先级中最高的非空链表取走一串任务
+// 按 count / consumers 的份额最多取 pop_batch 个，任务少时不抢其他线程的活
+static inline void *__pop_list(task_queue_t *queue, int from, int to) {
   spinlock_lock(&queue->lock);
-  if (queue->head == NULL) {
+  int prio = from;
+  while (prio <= to && queue->head[prio] == NULL)
+    prio++;
+  if (prio > to) {
     spinlock_unlock(&queue->lock);
     return NULL;
   }
+  int count = atomic_load_explicit(&queue->count, memory_order_relaxed);
+  int consumers = atomic_load_explicit(&queue->consumers, memory_order_relaxed);
+  int take = count / (consumers > 0 ? consumers : 1);
+  if (take > queue->pop_batch)
+    take = queue->pop_batch;
+
   task_t *task;
-  task = queue->head;
+  task = queue->head[prio];
 
   void **link = (void **)task;
-  queue->head = *link;
+  int i;
+  for (i = 1; i < take && *link; i++)
+    link = (void **)*link;
+  queue->head[prio] = *link;
+  *link = NULL;
+  atomic_store_explicit(&queue->count, count - i, memory_order_relaxed);
 
-  if (queue->head == NULL) {
-    queue->tail = &queue->head;
+  if (queue->head[prio] == NULL) {
+    queue->tail[prio] = &queue->head[prio];
   }
   spinlock_unlock(&queue->lock);
   return task;
 }
 
-static inline void *__get_task(task_queue_t *queue) {
+// 取走一串任务（以 NULL 结尾），队列空返回 NULL
+static inline void *__pop_task(task_queue_t *queue) {
+  if (queue->mode != THRDPOOL_QUEUE_LOCKFREE)
+    return __pop_list(queue, THRDPOOL_PRIO_HIGH, THRDPOOL_PRIO_LOW);
+
+  // 高优先级链表 -> 环形队列 -> 其余链表；链表全空时不碰锁
+  void **task;
+  if (atomic_load_explicit(&queue->count, memory_order_relaxed) > 0 &&
+      (task = (void **)__pop_list(queue, THRDPOOL_PRIO_HIGH, THRDPOOL_PRIO_HIGH)))
+    return task;
+  if ((task = (void **)mpmc_queue_pop(queue->ring))) {
+    *task = NULL;
+    return task;
+  }
+  if (atomic_load_explicit(&queue->count, memory_order_relaxed) > 0)
+    return __pop_list(queue, THRDPOOL_PRIO_NORMAL, THRDPOOL_PRIO_LOW);
+  return NULL;
+}
+
+static inline uint64_t __now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline int __timer_less(const timer_entry_t *a, const timer_entry_t *b) {
+  return a->deadline < b->deadline || (a->deadline == b->deadline && a->seq < b->seq);
+}
+
+// 以下堆操作都在 timer_lock 内
+static int __timer_push(thrdpool_t *pool, uint64_t deadline, task_t *task) {
+  if (pool->timer_count == pool->timer_cap) {
+    int cap = pool->timer_cap ? pool->timer_cap * 2 : 16;
+    timer_entry_t *timers = (timer_entry_t *)realloc(pool->timers, sizeof(*timers) * cap);
+    if (!timers)
+      return -1;
+    pool->timers = timers;
+    pool->timer_cap = cap;
+  }
+  timer_entry_t entry = {deadline, pool->timer_seq++, task};
+  int i = pool->timer_count++;
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (!__timer_less(&entry, &pool->timers[parent]))
+      break;
+    pool->timers[i] = pool->timers[parent];
+    i = parent;
+  }
+  pool->timers[i] = entry;
+  return 0;
+}
+
+static task_t *__timer_pop(thrdpool_t *pool) {
+  task_t *task = pool->timers[0].task;
+  timer_entry_t last = pool->timers[--pool->timer_count];
+  int i = 0, n = pool->timer_count;
+  for (;;) {
+    int child = i * 2 + 1;
+    if (child >= n)
+      break;
+    if (child + 1 < n && __timer_less(&pool->timers[child + 1], &pool->timers[child]))
+      child++;
+    if (!__timer_less(&pool->timers[child], &last))
+      break;
+    pool->timers[i] = pool->timers[child];
+    i = child;
+  }
+  if (n > 0)
+    pool->timers[i] = last;
+  return task;
+}
+
+static inline void __timer_update_deadline(thrdpool_t *pool) {
+  atomic_store(&pool->next_deadline,
+               pool->timer_count ? pool->timers[0].deadline : UINT64_MAX);
+}
+
+// 把到期的延迟任务挪进普通优先级链表；堆空或未到期时只有一次原子读
+static void __timers_expire(thrdpool_t *pool) {
+  uint64_t next = atomic_load_explicit(&pool->next_deadline, memory_order_relaxed);
+  if (next == UINT64_MAX)
+    return;
+  uint64_t now = __now_ns();
+  if (now < next)
+    return;
+
+  task_t *head = NULL, *tail = NULL, *task;
+  int n = 0, empty;
+  spinlock_lock(&pool->timer_lock);
+  while (pool->timer_count > 0 && pool->timers[0].deadline <= now) {
+    task = __timer_pop(pool);
+    task->next = NULL;
+    if (tail)
+      tail->next = task;
+    else
+      head = task;
+    tail = task;
+    n++;
+  }
+  __timer_update_deadline(pool);
+  empty = pool->timer_count == 0;
+  spinlock_unlock(&pool->timer_lock);
+
+  task_queue_t *queue = pool->task_queue;
+  if (n)
+    __add_list(queue, head, tail, n, THRDPOOL_PRIO_NORMAL);
+  // 排空停止时，最后一批延迟任务到期后唤醒其余线程检查退出条件
+  if (empty && atomic_load(&queue->block) == 0)
+    eventcount_notify(&queue->ec, 1);
+}
+
+// 即将休眠的线程计算休眠时长：-1 不限时，0 已有任务到期，>0 承担定时职责限时休眠
+static long long __timer_wait_ns(thrdpool_t *pool) {
+  uint64_t next = atomic_load(&pool->next_deadline);
+  if (next == UINT64_MAX)
+    return -1;
+  uint64_t now = __now_ns();
+  if (now >= next)
+    return 0;
+  int expected = 0;
+  if (!atomic_compare_exchange_strong(&pool->timer_duty, &expected, 1))
+    return -1;
+  return (long long)(next - now);
+}
+
+static void __local_push(local_queue_t *local, task_t *head, task_t *tail, int n) {
+  tail->next = NULL;
+  spinlock_lock(&local->lock);
+  *local->tail = head;
+  local->tail = &tail->next;
+  atomic_store_explicit(&local->count,
+                        atomic_load_explicit(&local->count, memory_order_relaxed) + n,
+                        memory_order_relaxed);
+  spinlock_unlock(&local->lock);
+}
+
+// 取走一半（至少一个，至多 max 个）；本线程与窃取者都从队头取
+// 窃取者（steal 非 0）遇到锁被占用直接放弃，去看下一个线程，不在别人的锁上自旋
+static task_t *__local_take(local_queue_t *local, int max, int steal) {
+  if (atomic_load_explicit(&local->count, memory_order_relaxed) == 0)
+    return NULL;
+  if (steal) {
+    if (spinlock_trylock(&local->lock) == 0)
+      return NULL;
+  } else {
+    spinlock_lock(&local->lock);
+  }
+  task_t *task = (task_t *)local->head;
+  if (!task) {
+    spinlock_unlock(&local->lock);
+    return NULL;
+  }
+  int count = atomic_load_explicit(&local->count, memory_order_relaxed);
+  int take = (count + 1) / 2, i;
+  if (take > max)
+    take = max;
+  void **link = (void **)task;
+  for (i = 1; i < take; i++)
+    link = (void **)*link;
+  local->head = *link;
+  *link = NULL;
+  if (!local->head)
+    local->tail = &local->head;
+  atomic_store_explicit(&local->count, count - take, memory_order_relaxed);
+  spinlock_unlock(&local->lock);
+  return task;
+}
+
+// 工作线程内部的提交进自己的本地队列
+// 外部线程第一次提交时按轮转分到一个在岗线程，之后一直提交给它：
+// 逐个任务轮转会让每个生产者轮流占用所有本地队列的锁，单核上实测吞吐反而减半，
+// 生产者少于工作线程时由窃取把任务摊开
+static void __local_submit(thrdpool_t *pool, task_t *head, task_t *tail, int n) {
+  thrdpool_worker_t *self = t_worker;
+  int idx;
+  if (self && self->pool == pool) {
+    idx = self->id;
+  } else {
+    if (t_home_pool != pool) {
+      t_home_pool = pool;
+      t_home_slot = atomic_fetch_add_explicit(&pool->rr, 1u, memory_order_relaxed);
+    }
+    // 先读 consumers 再读数组：扩容时先发布数组再放开名额，下标不会越界
+    int consumers = atomic_load(&pool->task_queue->consumers);
+    idx = (int)(t_home_slot % (unsigned)consumers);
+  }
+  local_queue_t **locals = atomic_load_explicit(&pool->locals, memory_order_acquire);
+  __local_push(locals[idx], head, tail, n);
+  __wakeup(pool->task_queue, n);
+}
+
+// 从编号 id 之后的线程依次窃取，扫描全部已分配的本地队列
+static task_t *__local_steal(thrdpool_t *pool, int id) {
+  local_queue_t **locals = atomic_load_explicit(&pool->locals, memory_order_acquire);
+  int n = atomic_load_explicit(&pool->nlocals, memory_order_acquire), i;
   task_t *task;
-  // 虚假唤醒
-  while ((task = __pop_task(queue)) == NULL) {
-    pthread_mutex_lock(&queue->mutex);
-    if (queue->block == 0) {
-      pthread_mutex_unlock(&queue->mutex);
+  for (i = 1; i < n; i++) {
+    if ((task = __local_take(locals[(id + i) % n], pool->task_queue->pop_batch, 1)))
+      return task;
+  }
+  return NULL;
+}
+
+// 工作窃取模式的取任务顺序：高优先级 -> 本地 -> 窃取 -> 其余共享链表（到期的延迟任务、低优先级）
+static inline void *__pop_work(thrdpool_t *pool, int id) {
+  task_queue_t *queue = pool->task_queue;
+  if (queue->mode != THRDPOOL_QUEUE_STEALING)
+    return __pop_task(queue);
+
+  void *task;
+  if (atomic_load_explicit(&queue->count, memory_order_relaxed) > 0 &&
+      (task = __pop_list(queue, THRDPOOL_PRIO_HIGH, THRDPOOL_PRIO_HIGH)))
+    return task;
+  local_queue_t **locals = atomic_load_explicit(&pool->locals, memory_order_acquire);
+  if ((task = __local_take(locals[id], queue->pop_batch, 0)))
+    return task;
+  if ((task = __local_steal(pool, id)))
+    return task;
+  if (atomic_load_explicit(&queue->count, memory_order_relaxed) > 0)
+    return __pop_list(queue, THRDPOOL_PRIO_NORMAL, THRDPOOL_PRIO_LOW);
+  return NULL;
+}
+
+// 保证编号 [0, n) 都有本地队列，在 resize_mutex 内或线程启动前调用
+static int __locals_reserve(thrdpool_t *pool, int n) {
+  if (pool->task_queue->mode != THRDPOOL_QUEUE_STEALING)
+    return 0;
+  int have = atomic_load(&pool->nlocals);
+  if (n <= have)
+    return 0;
+  local_queue_t **locals = atomic_load(&pool->locals);
+  if (n > pool->locals_cap) {
+    int cap = pool->locals_cap ? pool->locals_cap : 4;
+    while (cap < n)
+      cap *= 2;
+    void **retired = (void **)realloc(pool->retired_locals,
+                                      sizeof(void *) * (pool->nretired_locals + 1));
+    if (!retired)
+      return -1;
+    pool->retired_locals = retired;
+    local_queue_t **bigger = (local_queue_t **)calloc(cap, sizeof(*bigger));
+    if (!bigger)
+      return -1;
+    int i;
+    for (i = 0; i < have; i++)
+      bigger[i] = locals[i];
+    if (locals)
+      pool->retired_locals[pool->nretired_locals++] = locals;
+    locals = bigger;
+    pool->locals_cap = cap;
+    atomic_store_explicit(&pool->locals, locals, memory_order_release);
+  }
+  for (; have < n; have++) {
+    void *mem = NULL;
+    if (posix_memalign(&mem, 64, sizeof(local_queue_t) < 64 ? 64 : sizeof(local_queue_t)) != 0)
+      return -1;
+    local_queue_t *local = (local_queue_t *)mem;
+    spinlock_init(&local->lock);
+    local->head = NULL;
+    local->tail = &local->head;
+    atomic_init(&local->count, 0);
+    locals[have] = local;
+    atomic_store_explicit(&pool->nlocals, have + 1, memory_order_release);
+  }
+  return 0;
+}
+
+// 保证编号 [0, n) 都有私有存储，在创建线程的线程里调用 worker_init
+static int __storage_reserve(thrdpool_t *pool, int n) {
+  if (!pool->worker_init || n <= pool->nstorage)
+    return 0;
+  void **storage = (void **)realloc(pool->storage, sizeof(void *) * n);
+  if (!storage)
+    return -1;
+  pool->storage = storage;
+  for (; pool->nstorage < n; pool->nstorage++) {
+    void *local = pool->worker_init(pool->nstorage, pool->worker_user);
+    if (!local)
+      return -1;
+    storage[pool->nstorage] = local;
+  }
+  return 0;
+}
+
+static void __storage_destroy(thrdpool_t *pool) {
+  int i;
+  if (pool->worker_fini) {
+    for (i = 0; i < pool->nstorage; i++)
+      pool->worker_fini(pool->storage[i], pool->worker_user);
+  }
+  free(pool->storage);
+}
+
+static void __locals_destroy(thrdpool_t *pool) {
+  local_queue_t **locals = atomic_load(&pool->locals);
+  int n = atomic_load(&pool->nlocals), i;
+  task_t *task, *next;
+  for (i = 0; i < n; i++) {
+    for (task = (task_t *)locals[i]->head; task; task = next) {
+      next = (task_t *)task->next;
+      __task_free(task);
+    }
+    spinlock_destroy(&locals[i]->lock);
+    free(locals[i]);
+  }
+  free(locals);
+  for (i = 0; i < pool->nretired_locals; i++)
+    free(pool->retired_locals[i]);
+  free(pool->retired_locals);
+}
+
+static inline void *__get_task(thrdpool_t *pool, int id) {
+  task_queue_t *queue = pool->task_queue;
+  task_t *task;
+  unsigned key;
+  long long timeout;
+  int timed = 0;
+  for (;;) {
+    __timers_expire(pool);
+    if ((task = (task_t *)__pop_work(pool, id)))
+      break;
+    // 1. 登记为等待者并记下 epoch
+    // 2. 重新检查队列与退出条件：登记之前入队的任务在这里一定能看到
+    // 3. 登记之后的入队会改变 epoch，futex_wait 立即返回
+    // 虚假唤醒由外层循环重新检查
+    key = eventcount_prepare_wait(&queue->ec);
+    if ((task = (task_t *)__pop_work(pool, id))) {
+      eventcount_cancel_wait(&queue->ec);
+      break;
+    }
+    // 排空停止要等延迟任务全部到期
+    if ((atomic_load(&queue->block) == 0 &&
+         atomic_load(&pool->next_deadline) == UINT64_MAX) ||
+        atomic_load(&pool->stop) == 1 || id >= atomic_load(&queue->consumers)) {
+      eventcount_cancel_wait(&queue->ec);
       return NULL;
     }
-    // 1. 先 unlock(&mtx)
-    // 2. 在 cond 休眠
-    // --- __add_task 时唤醒
-    // 3. 在 cond 唤醒
-    // 4. 加上 lock(&mtx);
-    pthread_cond_wait(&queue->cond, &queue->mutex);
-    pthread_mutex_unlock(&queue->mutex);
+    timeout = __timer_wait_ns(pool);
+    if (timeout == 0) {
+      eventcount_cancel_wait(&queue->ec);
+      continue;
+    }
+    eventcount_wait_timeout(&queue->ec, key, timeout);
+    if (timeout > 0) {
+      atomic_store(&pool->timer_duty, 0);
+      timed = 1;
+    }
   }
+  // 定时职责的线程去执行任务了，堆里还有定时器时交给另一个休眠线程
+  if (timed && atomic_load(&pool->next_deadline) != UINT64_MAX)
+    eventcount_notify(&queue->ec, 0);
   return task;
 }
 
+// 调整在岗线程数，唤醒休眠线程检查自己是否被裁撤
+static void __set_consumers(task_queue_t *queue, int n) {
+  atomic_store(&queue->consumers, n);
+  eventcount_notify(&queue->ec, 1);
+}
+
 static void __taskqueue_destroy(task_queue_t *queue) {
-  task_t *task;
+  task_t *task, *next;
   while ((task = __pop_task(queue))) {
-    free(task);
+    for (; task; task = next) {
+      next = (task_t *)task->next;
+      __task_free(task);
+    }
+  }
+  if (queue->ring) {
+    mpmc_queue_destroy(queue->ring);
+    free(queue->ring);
   }
   spinlock_destroy(&queue->lock);
-  pthread_cond_destroy(&queue->cond);
-  pthread_mutex_destroy(&queue->mutex);
+  eventcount_destroy(&queue->ec);
   free(queue);
 }
 
+static void __wakeup_idle_waiters(thrdpool_t *pool) {
+  pthread_mutex_lock(&pool->idle_mutex);
+  pthread_cond_broadcast(&pool->idle_cond);
+  pthread_mutex_unlock(&pool->idle_mutex);
+}
+
+// n 个任务执行完（或被放弃）
+// pending 与 idle_waiters 都用顺序一致的原子操作，和 thrdpool_wait_idle 构成
+// 先写后读的对称握手：要么这里看到等待者，要么等待者看到 pending 归零
+static inline void __tasks_done(thrdpool_t *pool, long n) {
+  if (atomic_fetch_sub(&pool->pending, n) == n &&
+      atomic_load(&pool->idle_waiters) > 0)
+    __wakeup_idle_waiters(pool);
+}
+
 static void *__thrdpool_worker(void *arg) {
-  thrdpool_t *pool = (thrdpool_t *)arg;
-  task_t *task;
+  thrdpool_worker_t *worker = (thrdpool_worker_t *)arg;
+  thrdpool_t *pool = worker->pool;
+  task_queue_t *queue = pool->task_queue;
+  task_t *task, *next;
   void *ctx;
+  long done;
 
-  while (atomic_load(&pool->quit) == 0) {
-    task = (task_t *)__get_task(pool->task_queue);
+  t_worker = worker;
+  while (atomic_load(&pool->stop) == 0 &&
+         worker->id < atomic_load(&queue->consumers)) {
+    task = (task_t *)__get_task(pool, worker->id);
     if (!task)
       break;
-    handler_pt func = task->func;
-    ctx = task->arg;
-    free(task);
-    func(ctx);
+    // 已经从队列摘下的一串任务全部执行完，避免丢任务
+    for (done = 0; task; task = next, done++) {
+      next = (task_t *)task->next;
+      handler_pt func = task->func;
+      ctx = task->arg;
+      __task_free(task);
+      func(ctx);
+      if (pool->worker_reset)
+        pool->worker_reset(worker->local, pool->worker_user);
+    }
+    __tasks_done(pool, done);
   }
 
+  // 被裁撤或排空退出时把本地队列剩下的任务交回共享链表
+  if (queue->mode == THRDPOOL_QUEUE_STEALING) {
+    local_queue_t *local = atomic_load(&pool->locals)[worker->id];
+    while ((task = __local_take(local, INT32_MAX, 0))) {
+      int n = 1;
+      for (next = task; next->next; next = (task_t *)next->next)
+        n++;
+      __add_list(queue, task, next, n, THRDPOOL_PRIO_NORMAL);
+    }
+  }
+  t_worker = NULL;
   return NULL;
 }
 
-static void __threads_terminate(thrdpool_t *pool) {
-  atomic_store(&pool->quit, 1);
-  __nonblock(pool->task_queue);
+// 启动编号 [from, to) 的工作线程，失败时 thrd_count 停在已启动的数量
+static int __workers_spawn(thrdpool_t *pool, int from, int to) {
+  pthread_attr_t attr;
+  int i = from;
+
+  if (pthread_attr_init(&attr) == 0) {
+    for (; i < to; i++) {
+      thrdpool_worker_t *worker = (thrdpool_worker_t *)malloc(sizeof(*worker));
+      if (!worker)
+        break;
+      worker->pool = pool;
+      worker->id = i;
+      worker->local = i < pool->nstorage ? pool->storage[i] : NULL;
+      if (pthread_create(&worker->thread, &attr, __thrdpool_worker, worker) != 0) {
+        free(worker);
+        break;
+      }
+      pool->workers[i] = worker;
+    }
+    pthread_attr_destroy(&attr);
+  }
+  pool->thrd_count = i;
+  return i == to ? 0 : -1;
+}
+
+static void __workers_join(thrdpool_t *pool, int from, int to) {
   int i;
-  for (i = 0; i < pool->thrd_count; i++) {
-    pthread_join(pool->threads[i], NULL);
+  for (i = from; i < to; i++) {
+    pthread_join(pool->workers[i]->thread, NULL);
+    free(pool->workers[i]);
+    pool->workers[i] = NULL;
   }
 }
 
-static int __threads_create(thrdpool_t *pool, size_t thrd_count) {
-  pthread_attr_t attr;
-  int ret;
+static void __threads_terminate(thrdpool_t *pool) {
+  atomic_store(&pool->quit, 1);
+  atomic_store(&pool->stop, 1);
+  __nonblock(pool->task_queue);
+  __workers_join(pool, 0, pool->thrd_count);
+}
 
-  ret = pthread_attr_init(&attr);
+static int __threads_create(thrdpool_t *pool, int thrd_count) {
+  pool->workers = (thrdpool_worker_t **)malloc(sizeof(*pool->workers) * thrd_count);
+  if (pool->workers) {
+    pool->thrd_cap = thrd_count;
+    if (__workers_spawn(pool, 0, thrd_count) == 0)
+      return 0;
+    __threads_terminate(pool);
+    free(pool->workers);
+  }
+  return -1;
+}
 
-  if (ret == 0) {
-    pool->threads = (pthread_t *)malloc(sizeof(pthread_t) * thrd_count);
-    if (pool->threads) {
-      int i = 0;
-      for (; i < thrd_count; i++) {
-        if (pthread_create(&pool->threads[i], &attr, __thrdpool_worker, pool) !=
-            0) {
-          break;
-        }
-      }
-      pool->thrd_count = i;
-      pthread_attr_destroy(&attr);
-      if (i == thrd_count)
+static int __pool_sync_create(thrdpool_t *pool) {
+  if (pthread_mutex_init(&pool->resize_mutex, NULL) == 0) {
+    if (pthread_mutex_init(&pool->idle_mutex, NULL) == 0) {
+      if (pthread_cond_init(&pool->idle_cond, NULL) == 0)
         return 0;
-      __threads_terminate(pool);
-      free(pool->threads);
+      pthread_mutex_destroy(&pool->idle_mutex);
     }
-    ret = -1;
+    pthread_mutex_destroy(&pool->resize_mutex);
   }
-  return ret;
+  return -1;
+}
+
+static void __pool_sync_destroy(thrdpool_t *pool) {
+  pthread_cond_destroy(&pool->idle_cond);
+  pthread_mutex_destroy(&pool->idle_mutex);
+  pthread_mutex_destroy(&pool->resize_mutex);
+}
+
+static void __timers_init(thrdpool_t *pool) {
+  spinlock_init(&pool->timer_lock);
+  pool->timers = NULL;
+  pool->timer_count = 0;
+  pool->timer_cap = 0;
+  pool->timer_seq = 0;
+  atomic_init(&pool->next_deadline, UINT64_MAX);
+  atomic_init(&pool->timer_duty, 0);
+}
+
+// 丢弃未到期的延迟任务
+static void __timers_destroy(thrdpool_t *pool) {
+  while (pool->timer_count > 0)
+    __task_free(__timer_pop(pool));
+  free(pool->timers);
+  spinlock_destroy(&pool->timer_lock);
 }
 
 void thrdpool_terminate(thrdpool_t *pool) {
   atomic_store(&pool->quit, 1);
+  atomic_store(&pool->stop, 1);
   __nonblock(pool->task_queue);
+  __wakeup_idle_waiters(pool);
+}
+
+void thrdpool_drain(thrdpool_t *pool) {
+  // 只拒绝新任务；队列取空且 block == 0 时 __get_task 返回 NULL，工作线程自然退出
+  atomic_store(&pool->quit, 1);
+  __nonblock(pool->task_queue);
+}
+
+int thrdpool_wait_idle(thrdpool_t *pool) {
+  int ret = 0;
+  atomic_fetch_add(&pool->idle_waiters, 1);
+  pthread_mutex_lock(&pool->idle_mutex);
+  while (atomic_load(&pool->pending) != 0) {
+    if (atomic_load(&pool->stop) == 1) {
+      ret = -1;
+      break;
+    }
+    pthread_cond_wait(&pool->idle_cond, &pool->idle_mutex);
+  }
+  pthread_mutex_unlock(&pool->idle_mutex);
+  atomic_fetch_sub(&pool->idle_waiters, 1);
+  return ret;
+}
+
+void *thrdpool_worker_local(void) {
+  return t_worker ? t_worker->local : NULL;
+}
+
+// 工作线程写私有存储先于 __tasks_done 递减 pending，wait_idle 看到 pending 归零后
+// 这些写入对调用线程可见，合并时不需要额外同步
+int thrdpool_reduce(thrdpool_t *pool, thrdpool_fold_pt fold, void *acc) {
+  if (thrdpool_wait_idle(pool) != 0)
+    return -1;
+  int i;
+  pthread_mutex_lock(&pool->resize_mutex);
+  for (i = 0; i < pool->nstorage; i++)
+    fold(acc, pool->storage[i], pool->worker_user);
+  pthread_mutex_unlock(&pool->resize_mutex);
+  return 0;
+}
+
+int thrdpool_resize(thrdpool_t *pool, int thrd_count) {
+  if (thrd_count <= 0)
+    return -1;
+
+  int ret = 0;
+  pthread_mutex_lock(&pool->resize_mutex);
+  if (atomic_load(&pool->quit) == 1) {
+    pthread_mutex_unlock(&pool->resize_mutex);
+    return -1;
+  }
+
+  task_queue_t *queue = pool->task_queue;
+  int old = pool->thrd_count;
+  if (thrd_count > old) {
+    if (thrd_count > pool->thrd_cap) {
+      thrdpool_worker_t **workers = (thrdpool_worker_t **)realloc(
+          pool->workers, sizeof(*pool->workers) * thrd_count);
+      if (!workers) {
+        pthread_mutex_unlock(&pool->resize_mutex);
+        return -1;
+      }
+      pool->workers = workers;
+      pool->thrd_cap = thrd_count;
+    }
+    if (__locals_reserve(pool, thrd_count) != 0 ||
+        __storage_reserve(pool, thrd_count) != 0) {
+      pthread_mutex_unlock(&pool->resize_mutex);
+      return -1;
+    }
+    // 先放开名额，新线程启动后不会立即判定自己被裁撤
+    __set_consumers(queue, thrd_count);
+    ret = __workers_spawn(pool, old, thrd_count);
+    if (ret != 0)
+      __set_consumers(queue, pool->thrd_count);
+  } else if (thrd_count < old) {
+    // 编号不小于 thrd_count 的线程执行完手头的任务后退出
+    __set_consumers(queue, thrd_count);
+    __workers_join(pool, thrd_count, old);
+    pool->thrd_count = thrd_count;
+  }
+  pthread_mutex_unlock(&pool->resize_mutex);
+  return ret;
+}
+
+void thrdpool_dump_lock_stats(thrdpool_t *pool, FILE *fp) {
+#ifdef SPINLOCK_STATS
+  spinlock_dump_stats(&pool->task_queue->lock, "task_queue", fp);
+  local_queue_t **locals = atomic_load(&pool->locals);
+  int n = atomic_load(&pool->nlocals), i;
+  char name[32];
+  for (i = 0; i < n; i++) {
+    snprintf(name, sizeof(name), "local[%d]", i);
+    spinlock_dump_stats(&locals[i]->lock, name, fp);
+  }
+#else
+  (void)pool;
+  fprintf(fp, "spinlock stats disabled, rebuild thrd_pool.c with -DSPINLOCK_STATS\n");
+#endif
+}
+
+void thrdpool_attr_init(thrdpool_attr_t *attr) {
+  attr->thrd_count = 4;
+  attr->queue_mode = THRDPOOL_QUEUE_LOCKED;
+  attr->queue_capacity = 65536;
+  attr->pop_batch = 16;
+  attr->worker_init = NULL;
+  attr->worker_reset = NULL;
+  attr->worker_fini = NULL;
+  attr->worker_user = NULL;
 }
 
 thrdpool_t *thrdpool_create(int thrd_count) {
+  thrdpool_attr_t attr;
+  thrdpool_attr_init(&attr);
+  attr.thrd_count = thrd_count;
+  return thrdpool_create_ex(&attr);
+}
+
+thrdpool_t *thrdpool_create_ex(const thrdpool_attr_t *attr) {
   thrdpool_t *pool;
 
+  if (!attr || attr->thrd_count <= 0)
+    return NULL;
   pool = (thrdpool_t *)malloc(sizeof(*pool));
   if (pool) {
-    task_queue_t *queue = __taskqueue_create();
-    if (queue) {
-      pool->task_queue = queue;
-      atomic_init(&pool->quit, 0);
-      if (__threads_create(pool, thrd_count) == 0)
-        return pool;
-      __taskqueue_destroy(queue);
+    if (__pool_sync_create(pool) == 0) {
+      __timers_init(pool);
+      task_queue_t *queue = __taskqueue_create(attr);
+      if (queue) {
+        pool->task_queue = queue;
+        atomic_init(&pool->quit, 0);
+        atomic_init(&pool->stop, 0);
+        atomic_init(&pool->pending, 0);
+        atomic_init(&pool->idle_waiters, 0);
+        atomic_init(&pool->locals, NULL);
+        atomic_init(&pool->nlocals, 0);
+        atomic_init(&pool->rr, 0u);
+        pool->locals_cap = 0;
+        pool->retired_locals = NULL;
+        pool->nretired_locals = 0;
+        pool->storage = NULL;
+        pool->nstorage = 0;
+        pool->worker_init = attr->worker_init;
+        pool->worker_reset = attr->worker_reset;
+        pool->worker_fini = attr->worker_fini;
+        pool->worker_user = attr->worker_user;
+        if (__locals_reserve(pool, attr->thrd_count) == 0 &&
+            __storage_reserve(pool, attr->thrd_count) == 0 &&
+            __threads_create(pool, attr->thrd_count) == 0)
+          return pool;
+        __storage_destroy(pool);
+        __locals_destroy(pool);
+        __taskqueue_destroy(queue);
+      }
+      __timers_destroy(pool);
+      __pool_sync_destroy(pool);
     }
     free(pool);
   }
   return NULL;
 }
 
+// 当前线程是否是 pool 自己的工作线程
+static inline int __in_pool(thrdpool_t *pool) {
+  return t_worker && t_worker->pool == pool;
+}
+
 int thrdpool_post(thrdpool_t *pool, handler_pt func, void *arg) {
+  return thrdpool_post_priority(pool, func, arg, THRDPOOL_PRIO_NORMAL);
+}
+
+int thrdpool_post_priority(thrdpool_t *pool, handler_pt func, void *arg,
+                           thrdpool_priority_t prio) {
+  if (prio < THRDPOOL_PRIO_HIGH || prio > THRDPOOL_PRIO_LOW)
+    return -1;
   if (atomic_load(&pool->quit) == 1)
     return -1;
-  task_t *task = (task_t *)malloc(sizeof(task_t));
+  task_t *task = __task_alloc();
   if (!task)
     return -1;
   task->func = func;
   task->arg = arg;
-  __add_task(pool->task_queue, task);
+  // 入队前计数，保证执行完的递减不会先于这里的递增
+  atomic_fetch_add(&pool->pending, 1);
+  if (pool->task_queue->mode == THRDPOOL_QUEUE_STEALING && prio == THRDPOOL_PRIO_NORMAL) {
+    __local_submit(pool, task, task, 1);
+    return 0;
+  }
+  // 无锁队列满时外部线程让出 CPU 等待消费者腾出槽位（背压），线程池退出时放弃；
+  // 工作线程自己就是消费者，所有线程都在任务里提交时没人消费会活锁，溢出到普通优先级链表
+  while (__add_task(pool->task_queue, task, prio) != 0) {
+    if (__in_pool(pool)) {
+      __add_list(pool->task_queue, task, task, 1, THRDPOOL_PRIO_NORMAL);
+      return 0;
+    }
+    if (atomic_load(&pool->quit) == 1) {
+      __task_free(task);
+      __tasks_done(pool, 1);
+      return -1;
+    }
+    sched_yield();
+  }
   return 0;
 }
 
-void thrdpool_waitdone(thrdpool_t *pool) {
+int thrdpool_post_after(thrdpool_t *pool, long delay_ms, handler_pt func, void *arg) {
+  if (delay_ms <= 0)
+    return thrdpool_post(pool, func, arg);
+  if (atomic_load(&pool->quit) == 1)
+    return -1;
+  task_t *task = __task_alloc();
+  if (!task)
+    return -1;
+  task->func = func;
+  task->arg = arg;
+
+  uint64_t deadline = __now_ns() + (uint64_t)delay_ms * 1000000ull;
+  int earliest;
+  spinlock_lock(&pool->timer_lock);
+  if (__timer_push(pool, deadline, task) != 0) {
+    spinlock_unlock(&pool->timer_lock);
+    __task_free(task);
+    return -1;
+  }
+  // 延迟任务到期前也算未完成，thrdpool_wait_idle 会等它执行完
+  atomic_fetch_add(&pool->pending, 1);
+  earliest = pool->timers[0].task == task;
+  if (earliest)
+    __timer_update_deadline(pool);
+  spinlock_unlock(&pool->timer_lock);
+
+  // 新的堆顶比承担定时职责的线程的休眠期限更早，唤醒全部休眠线程重新计算
+  if (earliest)
+    eventcount_notify(&pool->task_queue->ec, 1);
+  return 0;
+}
+
+int thrdpool_post_batch(thrdpool_t *pool, handler_pt *funcs, void **args, int n) {
+  if (n <= 0)
+    return 0;
+  if (atomic_load(&pool->quit) == 1)
+    return -1;
+
+  // 先在本地串好整条链，全部分配成功才提交
+  task_t *head = NULL, *tail = NULL, *task;
   int i;
-  for (i = 0; i < pool->thrd_count; i++) {
-    pthread_join(pool->threads[i], NULL);
+  for (i = 0; i < n; i++) {
+    task = __task_alloc();
+    if (!task) {
+      for (; head; head = task) {
+        task = (task_t *)head->next;
+        __task_free(head);
+      }
+      return -1;
+    }
+    task->func = funcs[i];
+    task->arg = args ? args[i] : NULL;
+    task->next = NULL;
+    if (tail)
+      tail->next = task;
+    else
+      head = task;
+    tail = task;
+  }
+  atomic_fetch_add(&pool->pending, n);
+
+  task_queue_t *queue = pool->task_queue;
+  if (queue->mode == THRDPOOL_QUEUE_STEALING) {
+    // 整串进一个本地队列，由空闲线程窃取分摊
+    __local_submit(pool, head, tail, n);
+    return 0;
+  }
+  if (queue->mode != THRDPOOL_QUEUE_LOCKFREE) {
+    __add_list(queue, head, tail, n, THRDPOOL_PRIO_NORMAL);
+    return 0;
   }
+
+  // 无锁队列逐个入环，满时让出 CPU（工作线程改为把剩余的整串挂到普通优先级链表）；
+  // 全部入队后统一唤醒一次
+  for (i = 0, task = head; task; task = head, i++) {
+    head = (task_t *)task->next;
+    while (mpmc_queue_push(queue->ring, task) != 0) {
+      if (__in_pool(pool)) {
+        __add_list(queue, task, tail, n - i, THRDPOOL_PRIO_NORMAL);
+        __wakeup(queue, i);
+        return 0;
+      }
+      if (atomic_load(&pool->quit) == 1) {
+        __task_free(task);
+        for (; head; head = task) {
+          task = (task_t *)head->next;
+          __task_free(head);
+        }
+        __wakeup(queue, n);
+        __tasks_done(pool, n - i);
+        return -1;
+      }
+      sched_yield();
+    }
+  }
+  __wakeup(queue, n);
+  return 0;
+}
+
+void thrdpool_waitdone(thrdpool_t *pool) {
+  pthread_mutex_lock(&pool->resize_mutex);
+  __workers_join(pool, 0, pool->thrd_count);
+  pthread_mutex_unlock(&pool->resize_mutex);
+  __storage_destroy(pool);
+  __locals_destroy(pool);
   __taskqueue_destroy(pool->task_queue);
-  free(pool->threads);
+  __timers_destroy(pool);
+  __pool_sync_destroy(pool);
+  free(pool->workers);
   free(pool);
 }
@@ -1,26 +1,103 @@
 #ifndef _THREAD_POOL_H
 #define _THREAD_POOL_H
 
+#include <stdio.h>
+
 typedef struct thrdpool_s thrdpool_t;
 // 任务执行的规范 ctx 上下文
 typedef void (*handler_pt)(void * /* ctx */);
 
+// 任务队列实现
+typedef enum {
+  THRDPOOL_QUEUE_LOCKED = 0,   // 自旋锁保护的链表（无界）
+  THRDPOOL_QUEUE_LOCKFREE = 1, // 带槽位序号的无锁环形队列（有界，满时 post 让出 CPU 重试）
+  THRDPOOL_QUEUE_STEALING = 2, // 每个工作线程一个本地队列：任务内 post 进自己的队列，
+                               // 外部线程按轮转各分到一个本地队列，空闲线程从其他线程窃取
+} thrdpool_queue_mode_t;
+
+// 任务优先级：高优先级的任务先被取走；同一优先级先进先出
+typedef enum {
+  THRDPOOL_PRIO_HIGH = 0,
+  THRDPOOL_PRIO_NORMAL = 1, // thrdpool_post 的优先级
+  THRDPOOL_PRIO_LOW = 2,
+  THRDPOOL_PRIO_LEVELS,
+} thrdpool_priority_t;
+
+// 工作线程私有存储的回调，user 为 thrdpool_attr_t.worker_user
+// init 为编号 id 的工作线程创建私有存储（例如预分配的 arena），返回 NULL 表示失败
+typedef void *(*thrdpool_worker_init_pt)(int id, void *user);
+// reset 在该线程每执行完一个任务后调用；fini 在 thrdpool_waitdone 时释放私有存储
+typedef void (*thrdpool_worker_hook_pt)(void *local, void *user);
+// thrdpool_reduce 把每个工作线程的部分结果 local 合并进 acc
+typedef void (*thrdpool_fold_pt)(void *acc, void *local, void *user);
+
+// 线程池创建参数，先用 thrdpool_attr_init 填默认值再按需修改
+typedef struct thrdpool_attr_s {
+  int thrd_count;                   // 工作线程数
+  thrdpool_queue_mode_t queue_mode; // 任务队列实现
+  unsigned queue_capacity;          // 无锁队列容量，向上取整为 2 的幂
+  int pop_batch;                    // 工作线程每次最多取走的任务数（链表模式）
+  thrdpool_worker_init_pt worker_init;  // 为 NULL 时不创建私有存储
+  thrdpool_worker_hook_pt worker_reset; // 可为 NULL
+  thrdpool_worker_hook_pt worker_fini;  // 可为 NULL
+  void *worker_user;
+} thrdpool_attr_t;
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+void thrdpool_attr_init(thrdpool_attr_t *attr);
+
 // 对称处理
 thrdpool_t *thrdpool_create(int thrd_count);
 
+thrdpool_t *thrdpool_create_ex(const thrdpool_attr_t *attr);
+
+// 立即停止：拒绝新任务，工作线程执行完手头的任务后退出，队列中剩余任务被丢弃
 void thrdpool_terminate(thrdpool_t * pool);
 
+// 排空后停止：拒绝新任务（包括任务内部的 post），已入队的任务与尚未到期的延迟任务
+// 全部执行完后工作线程退出
+void thrdpool_drain(thrdpool_t *pool);
+
+// 阻塞直到队列为空、没有任务在执行且没有未到期的延迟任务；线程池被 terminate 时返回 -1
+// 不要在线程池的任务中调用
+int thrdpool_wait_idle(thrdpool_t *pool);
+
+// 运行时调整工作线程数：扩容立即启动新线程；缩容时被裁撤的线程执行完手头的任务后退出，
+// 返回前已全部回收。成功返回 0
+int thrdpool_resize(thrdpool_t *pool, int thrd_count);
+
+// 输出任务队列自旋锁的竞争统计；thrd_pool.c 需以 -DSPINLOCK_STATS 编译
+void thrdpool_dump_lock_stats(thrdpool_t *pool, FILE *fp);
+
 int thrdpool_post(thrdpool_t *pool, handler_pt func, void *arg);
 
+int thrdpool_post_priority(thrdpool_t *pool, handler_pt func, void *arg,
+                           thrdpool_priority_t prio);
+
+// delay_ms 毫秒后以普通优先级执行；到期的任务由工作线程在取任务时挪入队列，
+// 全部空闲时其中一个线程按最近的到期时间限时休眠，不为每个定时器单独起线程
+int thrdpool_post_after(thrdpool_t *pool, long delay_ms, handler_pt func, void *arg);
+
+// 一次提交 n 个任务：funcs[i](args[i])，args 为 NULL 时参数全为 NULL
+// 链表模式下整串只加一次锁、唤醒一次；成功返回 0
+int thrdpool_post_batch(thrdpool_t *pool, handler_pt *funcs, void **args, int n);
+
+// 在任务中调用，返回当前工作线程的私有存储；不在工作线程中或未设置 worker_init 时返回 NULL
+void *thrdpool_worker_local(void);
+
+// 等待线程池空闲后，在调用线程中依次对每个私有存储调用 fold(acc, local, worker_user)，
+// 包括已被 resize 裁撤的线程留下的存储。调用期间不应有其他线程提交任务；
+// 线程池被 terminate 时返回 -1。不要在线程池的任务中调用
+int thrdpool_reduce(thrdpool_t *pool, thrdpool_fold_pt fold, void *acc);
+
 void thrdpool_waitdone(thrdpool_t *pool);
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif
\ No newline at end of file
+#endif
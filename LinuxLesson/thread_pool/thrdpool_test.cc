@@ -3,15 +3,27 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <algorithm>
 #include <atomic>
 #include <thread>
+#include <vector>
 #include <iostream>
 #include <unistd.h>
+#include <sys/resource.h>
 
 /**
  * shell: g++ -Wl,-rpath=./ thrdpool_test.cc -o thrdpool_test -I./ -L./ -lthrdpool -lpthread
+ * 对比 futex 事件计数与 mutex + cond 休眠：用 -DUSE_PTHREAD_COND 重新编译 thrd_pool.c，
+ * 比较同一场景的 exec per sec 与 sys（内核态 CPU 时间，反映唤醒系统调用的开销）
  */
 
+// 进程累计内核态 CPU 时间（毫秒）
+int64_t GetSysMs() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (int64_t)usage.ru_stime.tv_sec * 1000 + usage.ru_stime.tv_usec / 1000;
+}
+
 time_t GetTick() {
     return std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::steady_clock::now().time_since_epoch()
@@ -23,37 +35,321 @@ void JustTask(void *ctx) {
     ++g_count;
 }
 
-constexpr int64_t n = 1000000;
-
-void producer(thrdpool_t *pool) {
+void producer(thrdpool_t *pool, int64_t n) {
     for(int64_t i=0; i < n; ++i) {
         thrdpool_post(pool, JustTask, NULL);
     }
 }
 
-void test_thrdpool(int nproducer, int nconsumer) {
-    auto pool = thrdpool_create(nconsumer);
-    for (int i=0; i<nproducer; ++i) {
-        std::thread(&producer, pool).detach();
+constexpr int kBatch = 64;
+
+void batch_producer(thrdpool_t *pool, int64_t n) {
+    handler_pt funcs[kBatch];
+    for (int i = 0; i < kBatch; ++i) {
+        funcs[i] = JustTask;
     }
+    for (int64_t i = 0; i < n; i += kBatch) {
+        thrdpool_post_batch(pool, funcs, NULL, (int)std::min<int64_t>(kBatch, n - i));
+    }
+}
+
+void test_thrdpool(const char *name, thrdpool_queue_mode_t mode,
+                   int nproducer, int nconsumer, int64_t n, bool batch = false) {
+    thrdpool_attr_t attr;
+    thrdpool_attr_init(&attr);
+    attr.thrd_count = nconsumer;
+    attr.queue_mode = mode;
+    auto pool = thrdpool_create_ex(&attr);
+    g_count = 0;
 
     time_t t1 = GetTick();
+    int64_t sys1 = GetSysMs();
+    std::vector<std::thread> producers;
+    for (int i=0; i<nproducer; ++i) {
+        producers.emplace_back(batch ? &batch_producer : &producer, pool, n);
+    }
+
     // wait for all producer done
     while (g_count.load() != n*nproducer) {
-        usleep(100000);
+        usleep(1000);
+    }
+
+    time_t t2 = GetTick();
+    int64_t sys2 = GetSysMs();
+    // 生产者可能仍在 post 的唤醒路径上，销毁前等它们退出
+    for (auto &t : producers) {
+        t.join();
+    }
+    if (t2 == t1)
+        t2 = t1 + 1;
+
+    std::cout << name << " producer:" << nproducer << " consumer:" << nconsumer
+        << " used:" << t2-t1 << " exec per sec:"
+        << (double)g_count.load()*1000 / (t2-t1) << " sys:" << sys2-sys1 << std::endl;
+
+    thrdpool_terminate(pool);
+    thrdpool_waitdone(pool);
+}
+
+// 自旋锁链表 vs 无锁环形队列
+void compare_queue(int nproducer, int nconsumer, int64_t n) {
+    test_thrdpool("locked  ", THRDPOOL_QUEUE_LOCKED, nproducer, nconsumer, n);
+    test_thrdpool("lockfree", THRDPOOL_QUEUE_LOCKFREE, nproducer, nconsumer, n);
+    test_thrdpool("stealing", THRDPOOL_QUEUE_STEALING, nproducer, nconsumer, n);
+}
+
+// 逐个 post vs 每次 post_batch 64 个
+void compare_batch(int nproducer, int nconsumer, int64_t n) {
+    test_thrdpool("single  ", THRDPOOL_QUEUE_LOCKED, nproducer, nconsumer, n);
+    test_thrdpool("batch   ", THRDPOOL_QUEUE_LOCKED, nproducer, nconsumer, n, true);
+}
+
+// 分阶段复用线程池：wait_idle 作为阶段屏障，阶段之间 resize，最后排空停止
+void test_lifecycle(thrdpool_queue_mode_t mode) {
+    thrdpool_attr_t attr;
+    thrdpool_attr_init(&attr);
+    attr.thrd_count = 2;
+    attr.queue_mode = mode;
+    auto pool = thrdpool_create_ex(&attr);
+    g_count = 0;
+    const int widths[] = {4, 1, 8, 3};
+    int64_t expect = 0;
+    for (int width : widths) {
+        if (thrdpool_resize(pool, width) != 0) {
+            std::cout << "resize to " << width << " failed" << std::endl;
+        }
+        for (int i = 0; i < 10000; ++i) {
+            thrdpool_post(pool, JustTask, NULL);
+        }
+        expect += 10000;
+        thrdpool_wait_idle(pool);
+        std::cout << "phase width:" << width << " count:" << g_count.load()
+            << (g_count.load() == expect ? " ok" : " MISMATCH") << std::endl;
+    }
+
+    for (int i = 0; i < 10000; ++i) {
+        thrdpool_post(pool, JustTask, NULL);
+    }
+    expect += 10000;
+    thrdpool_dump_lock_stats(pool, stdout);
+    thrdpool_drain(pool);
+    int rejected = thrdpool_post(pool, JustTask, NULL);
+    thrdpool_waitdone(pool);
+    std::cout << "drain count:" << g_count.load()
+        << (g_count.load() == expect && rejected == -1 ? " ok" : " MISMATCH") << std::endl;
+}
+
+const char *ModeName(thrdpool_queue_mode_t mode) {
+    switch (mode) {
+    case THRDPOOL_QUEUE_LOCKFREE: return "lockfree";
+    case THRDPOOL_QUEUE_STEALING: return "stealing";
+    default: return "locked  ";
+    }
+}
+
+std::atomic<bool> g_gate{false};
+std::vector<int> g_order;   // 只有一个工作线程写
+std::vector<int64_t> g_fired;
+
+void GateTask(void *ctx) {
+    while (!g_gate.load()) {
+        std::this_thread::yield();
+    }
+}
+
+void RecordTask(void *ctx) {
+    g_order.push_back((int)(intptr_t)ctx);
+    g_fired.push_back(GetTick());
+}
+
+// 单工作线程：被阻塞期间按低、普通、高的顺序提交，放行后应按高、普通、低执行；
+// 延迟任务按到期时间而不是提交顺序执行
+void test_priority_and_timer(thrdpool_queue_mode_t mode) {
+    thrdpool_attr_t attr;
+    thrdpool_attr_init(&attr);
+    attr.thrd_count = 1;
+    attr.queue_mode = mode;
+    auto pool = thrdpool_create_ex(&attr);
+    g_order.clear();
+    g_fired.clear();
+
+    g_gate = false;
+    thrdpool_post(pool, GateTask, NULL);
+    thrdpool_post_priority(pool, RecordTask, (void *)3, THRDPOOL_PRIO_LOW);
+    thrdpool_post_priority(pool, RecordTask, (void *)2, THRDPOOL_PRIO_NORMAL);
+    thrdpool_post_priority(pool, RecordTask, (void *)1, THRDPOOL_PRIO_HIGH);
+    g_gate = true;
+    thrdpool_wait_idle(pool);
+    bool prio_ok = g_order == std::vector<int>{1, 2, 3};
+
+    g_order.clear();
+    g_fired.clear();
+    time_t t0 = GetTick();
+    thrdpool_post_after(pool, 60, RecordTask, (void *)60);
+    thrdpool_post_after(pool, 20, RecordTask, (void *)20);
+    thrdpool_post_after(pool, 40, RecordTask, (void *)40);
+    thrdpool_wait_idle(pool);
+    bool timer_ok = g_order == std::vector<int>{20, 40, 60};
+    for (size_t i = 0; timer_ok && i < g_order.size(); ++i) {
+        timer_ok = g_fired[i] - t0 >= g_order[i];
     }
 
+    std::cout << ModeName(mode) << " priority:" << (prio_ok ? "ok" : "MISMATCH")
+        << " timer:" << (timer_ok ? "ok" : "MISMATCH");
+    for (size_t i = 0; i < g_fired.size(); ++i) {
+        std::cout << " " << g_order[i] << "ms@" << g_fired[i] - t0;
+    }
+    std::cout << std::endl;
+
+    thrdpool_terminate(pool);
+    thrdpool_waitdone(pool);
+}
+
+thrdpool_t *g_fanout_pool;
+
+// 递归分治：每个任务在工作线程内提交两个子任务，深度 ctx 为 0 时停止
+void FanoutTask(void *ctx) {
+    ++g_count;
+    intptr_t depth = (intptr_t)ctx;
+    if (depth > 0) {
+        thrdpool_post(g_fanout_pool, FanoutTask, (void *)(depth - 1));
+        thrdpool_post(g_fanout_pool, FanoutTask, (void *)(depth - 1));
+    }
+}
+
+// 任务内提交：共享队列上所有线程争同一把锁；窃取模式下子任务进本线程的本地队列；
+// 无锁模式用很小的环，工作线程提交时环满要溢出到链表而不是互相等待
+void test_fanout(thrdpool_queue_mode_t mode, int nconsumer, int depth) {
+    thrdpool_attr_t attr;
+    thrdpool_attr_init(&attr);
+    attr.thrd_count = nconsumer;
+    attr.queue_mode = mode;
+    attr.queue_capacity = 256;
+    g_fanout_pool = thrdpool_create_ex(&attr);
+    g_count = 0;
+
+    time_t t1 = GetTick();
+    thrdpool_post(g_fanout_pool, FanoutTask, (void *)(intptr_t)depth);
+    thrdpool_wait_idle(g_fanout_pool);
     time_t t2 = GetTick();
+    if (t2 == t1)
+        t2 = t1 + 1;
+
+    int64_t expect = ((int64_t)2 << depth) - 1;
+    std::cout << ModeName(mode) << " fanout depth:" << depth << " consumer:" << nconsumer
+        << " used:" << t2-t1 << " exec per sec:" << (double)g_count.load()*1000 / (t2-t1)
+        << (g_count.load() == expect ? " ok" : " MISMATCH") << std::endl;
 
-    std::cout << t2 << " " << t1 << " " << "used:" << t2-t1 << " exec per sec:"
-        << (double)g_count.load()*1000 / (t2-t1) << std::endl;
+    thrdpool_terminate(g_fanout_pool);
+    thrdpool_waitdone(g_fanout_pool);
+}
+
+// 每个工作线程一块 arena：任务里从 arena 分配临时缓冲，执行完由 reset 整块回收；
+// 部分和留在私有存储里，最后用 thrdpool_reduce 合并，全程没有 malloc 和共享原子变量
+struct WorkerScratch {
+    char arena[4096];
+    size_t used;
+    size_t high_water;
+    int64_t sum;
+    int64_t tasks;
+};
+
+std::atomic<int> g_scratch_live{0};
+
+void *ScratchInit(int id, void *user) {
+    ++g_scratch_live;
+    return new WorkerScratch();
+}
 
+void ScratchReset(void *local, void *user) {
+    auto scratch = (WorkerScratch *)local;
+    scratch->high_water = std::max(scratch->high_water, scratch->used);
+    scratch->used = 0;
+}
+
+void ScratchFini(void *local, void *user) {
+    --g_scratch_live;
+    delete (WorkerScratch *)local;
+}
+
+void SumTask(void *ctx) {
+    auto scratch = (WorkerScratch *)thrdpool_worker_local();
+    int64_t v = (int64_t)(intptr_t)ctx;
+    auto buf = (int64_t *)(scratch->arena + scratch->used);
+    scratch->used += sizeof(int64_t) * 16;
+    for (int i = 0; i < 16; ++i) {
+        buf[i] = v;
+    }
+    for (int i = 0; i < 16; ++i) {
+        scratch->sum += buf[i];
+    }
+    ++scratch->tasks;
+}
+
+struct SumResult {
+    int64_t sum = 0;
+    int64_t tasks = 0;
+    size_t high_water = 0;
+    int workers = 0;
+};
+
+void FoldSum(void *acc, void *local, void *user) {
+    auto result = (SumResult *)acc;
+    auto scratch = (WorkerScratch *)local;
+    result->sum += scratch->sum;
+    result->tasks += scratch->tasks;
+    result->high_water = std::max(result->high_water, scratch->high_water);
+    ++result->workers;
+}
+
+// 中途缩容：被裁撤线程的部分和也要被合并
+void test_worker_local(thrdpool_queue_mode_t mode) {
+    thrdpool_attr_t attr;
+    thrdpool_attr_init(&attr);
+    attr.thrd_count = 4;
+    attr.queue_mode = mode;
+    attr.worker_init = ScratchInit;
+    attr.worker_reset = ScratchReset;
+    attr.worker_fini = ScratchFini;
+    auto pool = thrdpool_create_ex(&attr);
+
+    const int64_t n = 100000;
+    int64_t expect = 0;
+    for (int64_t i = 0; i < n; ++i) {
+        if (i == n / 2) {
+            thrdpool_resize(pool, 2);
+        }
+        thrdpool_post(pool, SumTask, (void *)(intptr_t)i);
+        expect += i * 16;
+    }
+    SumResult result;
+    int ret = thrdpool_reduce(pool, FoldSum, &result);
     thrdpool_terminate(pool);
     thrdpool_waitdone(pool);
+
+    bool ok = ret == 0 && result.sum == expect && result.tasks == n &&
+        result.workers == 4 && result.high_water == sizeof(int64_t) * 16 &&
+        g_scratch_live.load() == 0;
+    std::cout << ModeName(mode) << " reduce workers:" << result.workers
+        << " tasks:" << result.tasks << (ok ? " ok" : " MISMATCH") << std::endl;
 }
 
 int main() {
-    // test_thrdpool(1, 8);
-    test_thrdpool(4, 4);
+    test_priority_and_timer(THRDPOOL_QUEUE_LOCKED);
+    test_priority_and_timer(THRDPOOL_QUEUE_LOCKFREE);
+    test_priority_and_timer(THRDPOOL_QUEUE_STEALING);
+    test_lifecycle(THRDPOOL_QUEUE_LOCKED);
+    test_lifecycle(THRDPOOL_QUEUE_STEALING);
+    test_worker_local(THRDPOOL_QUEUE_LOCKED);
+    test_worker_local(THRDPOOL_QUEUE_STEALING);
+    // compare_queue(1, 8, 1000000);
+    compare_queue(4, 4, 1000000);
+    compare_queue(64, 4, 62500);
+    compare_batch(4, 4, 1000000);
+    test_fanout(THRDPOOL_QUEUE_LOCKED, 4, 19);
+    test_fanout(THRDPOOL_QUEUE_LOCKFREE, 4, 19);
+    test_fanout(THRDPOOL_QUEUE_STEALING, 4, 19);
+    // 单生产者喂不饱多个消费者：消费者频繁休眠/唤醒，主要成本在唤醒路径
+    test_thrdpool("wakeup  ", THRDPOOL_QUEUE_LOCKED, 1, 4, 1000000);
     return 0;
 }
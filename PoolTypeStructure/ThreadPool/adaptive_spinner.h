@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:自适应自旋等待
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace PoolTypeStructure {
+
+/// 自旋等待提示（x86 pause / ARM yield），降低自旋对超线程兄弟与功耗的影响
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * @brief 空闲线程休眠前的自适应自旋
+ * @details 等待分三段：pause自旋 -> yield让出 -> 由调用方休眠。
+ *          自旋预算取最近空闲间隔（≈任务到达间隔）EWMA的2倍并以maxSpin封顶：
+ *          - 任务每隔几微秒到达时，工作线程在自旋中接到任务，免去futex休眠/唤醒
+ *          - 任务到达间隔超过maxSpin时预算降为0，直接休眠，不空耗CPU
+ *          单核机器上自旋没有意义，只保留yield段。
+ *          每个工作线程独占一个实例，非线程安全
+ */
+class alignas(64) AdaptiveSpinner final {
+public:
+    /// yield段的轮数
+    static constexpr int kYieldRounds = 8;
+
+    explicit AdaptiveSpinner(std::chrono::nanoseconds maxSpin = std::chrono::microseconds(50))
+        : m_maxSpinNs(std::thread::hardware_concurrency() > 1 ? maxSpin.count() : 0),
+          m_averageIdleNs(m_maxSpinNs / 4) {}
+
+    /**
+     * @brief 在预算内自旋等待条件成立
+     * @param[in] ready 条件谓词，应只读取原子变量
+     * @return 条件在休眠前成立返回true，否则调用方应进入休眠
+     */
+    template <typename Pred>
+    bool SpinUntil(Pred ready) {
+        using Clock = std::chrono::steady_clock;
+        const int64_t budget = SpinBudgetNs();
+        if (budget > 0) {
+            const auto deadline = Clock::now() + std::chrono::nanoseconds(budget);
+            do {
+                for (int i = 0; i < kPausesPerCheck; ++i) {
+                    CpuRelax();
+                }
+                if (ready()) {
+                    return true;
+                }
+            } while (Clock::now() < deadline);
+        }
+
+        for (int i = 0; i < kYieldRounds; ++i) {
+            std::this_thread::yield();
+            if (ready()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 记录一次空闲时长（从无任务可取到取得下一个任务）
+     */
+    void RecordIdle(int64_t idleNs) {
+        // 截断长时间空闲，负载变密集时预算能在十次左右的到达内恢复
+        idleNs = std::min(idleNs, m_maxSpinNs * 4);
+        m_averageIdleNs += (idleNs - m_averageIdleNs) / kSmoothing;
+    }
+
+    /// 当前自旋预算（纳秒）
+    int64_t SpinBudgetNs() const {
+        if (m_averageIdleNs > m_maxSpinNs) {
+            return 0;
+        }
+        return std::min(m_averageIdleNs * 2, m_maxSpinNs);
+    }
+
+private:
+    static constexpr int kPausesPerCheck = 32;  // 每检查一次条件前的pause次数
+    static constexpr int64_t kSmoothing = 8;    // EWMA平滑系数 1/8
+
+    int64_t m_maxSpinNs;
+    int64_t m_averageIdleNs;
+};
+
+} // namespace PoolTypeStructure
@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:批量任务完成信号
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+
+namespace PoolTypeStructure {
+
+/**
+ * @brief 倒计数门闩（C++17下std::latch的替代）
+ * @details 一组任务共享一个门闩，替代N个future：
+ *          - 计数归零时唤醒所有等待者
+ *          - 记录第一个任务异常，在Wait时重新抛出
+ */
+class CountDownLatch final {
+public:
+    explicit CountDownLatch(size_t count) : m_count(count) {}
+
+    CountDownLatch(const CountDownLatch&) = delete;
+    CountDownLatch& operator=(const CountDownLatch&) = delete;
+
+    /**
+     * @brief 计数减一
+     * @param[in] error 任务异常，非空时仅保留第一个
+     */
+    void CountDown(std::exception_ptr error = nullptr) {
+        if (error) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error) {
+                m_error = error;
+            }
+        }
+        if (m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_condition.notify_all();
+        }
+    }
+
+    /**
+     * @brief 阻塞直到计数归零
+     * @exception 重新抛出第一个记录的任务异常
+     */
+    void Wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return TryWait(); });
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+    }
+
+    /// 计数是否已归零（不阻塞）
+    bool TryWait() const noexcept {
+        return m_count.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    std::atomic<size_t> m_count;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::exception_ptr m_error;
+};
+
+} // namespace PoolTypeStructure
@@ -0,0 +1,199 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:CPU/NUMA拓扑探测与线程绑核
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+
+#include <sched.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <tuple>
+
+#include "cpu_topology.h"
+
+namespace PoolTypeStructure {
+
+namespace {
+
+const char kCpuRoot[] = "/sys/devices/system/cpu/";
+const char kNodeRoot[] = "/sys/devices/system/node/";
+
+/// 读取/sys中的单行文本，失败返回false
+bool ReadLine(const std::string& path, std::string& line) {
+    std::ifstream file(path);
+    return static_cast<bool>(std::getline(file, line));
+}
+
+/// 读取/sys中的整数，失败返回fallback
+int ReadInt(const std::string& path, int fallback) {
+    std::string line;
+    if (!ReadLine(path, line)) {
+        return fallback;
+    }
+    char* end = nullptr;
+    long value = std::strtol(line.c_str(), &end, 10);
+    return end == line.c_str() ? fallback : static_cast<int>(value);
+}
+
+/// 当前进程允许运行的CPU集合
+std::vector<int> AllowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+} // namespace
+
+CpuTopology::CpuTopology(std::vector<CpuInfo> cpus) : m_cpus(std::move(cpus)) {
+    std::sort(m_cpus.begin(), m_cpus.end(),
+              [](const CpuInfo& lhs, const CpuInfo& rhs) { return lhs.cpu < rhs.cpu; });
+}
+
+CpuTopology CpuTopology::Detect() {
+    // CPU -> NUMA节点，节点目录不存在（非NUMA内核）时全部归入节点0
+    std::map<int, int> nodeOf;
+    std::string online;
+    if (ReadLine(std::string(kNodeRoot) + "online", online)) {
+        for (int node : ParseCpuList(online)) {
+            std::string list;
+            if (ReadLine(kNodeRoot + ("node" + std::to_string(node)) + "/cpulist", list)) {
+                for (int cpu : ParseCpuList(list)) {
+                    nodeOf[cpu] = node;
+                }
+            }
+        }
+    }
+
+    std::vector<CpuInfo> cpus;
+    for (int cpu : AllowedCpus()) {
+        const std::string topology = kCpuRoot + ("cpu" + std::to_string(cpu)) + "/topology/";
+        CpuInfo info;
+        info.cpu = cpu;
+        info.core = ReadInt(topology + "core_id", cpu);
+        info.package = ReadInt(topology + "physical_package_id", 0);
+        auto it = nodeOf.find(cpu);
+        info.node = it != nodeOf.end() ? it->second : 0;
+        cpus.push_back(info);
+    }
+    return CpuTopology(std::move(cpus));
+}
+
+std::vector<int> CpuTopology::ParseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        char* end = nullptr;
+        long first = std::strtol(range.c_str(), &end, 10);
+        if (end == range.c_str() || first < 0) {
+            continue;
+        }
+        long last = first;
+        if (*end == '-') {
+            const char* begin = end + 1;
+            last = std::strtol(begin, &end, 10);
+            if (end == begin || last < first) {
+                continue;
+            }
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+size_t CpuTopology::NodeCount() const {
+    std::vector<int> nodes;
+    for (const CpuInfo& info : m_cpus) {
+        nodes.push_back(info.node);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    return static_cast<size_t>(std::unique(nodes.begin(), nodes.end()) - nodes.begin());
+}
+
+int CpuTopology::NodeOf(int cpu) const {
+    auto it = std::lower_bound(m_cpus.begin(), m_cpus.end(), cpu,
+                               [](const CpuInfo& info, int value) { return info.cpu < value; });
+    return (it != m_cpus.end() && it->cpu == cpu) ? it->node : -1;
+}
+
+std::vector<int> CpuTopology::CompactOrder() const {
+    std::vector<CpuInfo> sorted = m_cpus;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const CpuInfo& lhs, const CpuInfo& rhs) {
+        return std::tie(lhs.node, lhs.package, lhs.core, lhs.cpu) <
+               std::tie(rhs.node, rhs.package, rhs.core, rhs.cpu);
+    });
+
+    std::vector<int> order;
+    for (const CpuInfo& info : sorted) {
+        order.push_back(info.cpu);
+    }
+    return order;
+}
+
+std::vector<int> CpuTopology::ScatterOrder() const {
+    // 节点内：同一物理核的第k个超线程排在所有物理核的第k-1个超线程之后
+    std::map<int, std::vector<std::tuple<int, int, int, int>>> perNode;
+    std::map<std::pair<int, int>, int> siblingRank;
+    for (const CpuInfo& info : m_cpus) {
+        const int rank = siblingRank[{info.package, info.core}]++;
+        perNode[info.node].emplace_back(rank, info.package, info.core, info.cpu);
+    }
+    for (auto& entry : perNode) {
+        std::sort(entry.second.begin(), entry.second.end());
+    }
+
+    // 节点间轮转
+    std::vector<int> order;
+    for (size_t i = 0; order.size() < m_cpus.size(); ++i) {
+        for (const auto& entry : perNode) {
+            if (i < entry.second.size()) {
+                order.push_back(std::get<3>(entry.second[i]));
+            }
+        }
+    }
+    return order;
+}
+
+bool PinCurrentThread(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+int CurrentCpu() {
+    return sched_getcpu();
+}
+
+} // namespace PoolTypeStructure
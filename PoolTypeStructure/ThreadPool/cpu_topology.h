@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:CPU/NUMA拓扑探测与线程绑核
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace PoolTypeStructure {
+
+/**
+ * @brief 单个逻辑CPU的拓扑位置
+ */
+struct CpuInfo {
+    int cpu = 0;      ///< 逻辑CPU编号
+    int core = 0;     ///< 物理核编号（同一package内唯一）
+    int package = 0;  ///< 物理封装（插槽）编号
+    int node = 0;     ///< NUMA节点编号
+};
+
+/**
+ * @brief 当前进程可用CPU的拓扑
+ * @details 仅依赖Linux的/sys与sched_getaffinity，不引入libnuma/hwloc：
+ *          - /sys/devices/system/cpu/cpuN/topology 提供core与package
+ *          - /sys/devices/system/node/nodeN/cpulist 提供NUMA节点归属
+ *          - 只保留进程亲和性掩码允许的CPU（容器、taskset等场景）
+ *          读取失败时退化为单节点、每个CPU独占一个核
+ */
+class CpuTopology final {
+public:
+    /**
+     * @brief 探测当前机器拓扑
+     */
+    static CpuTopology Detect();
+
+    /**
+     * @brief 由CPU列表构造（用于测试或调用方自行提供拓扑）
+     * @param[in] cpus 逻辑CPU列表
+     */
+    explicit CpuTopology(std::vector<CpuInfo> cpus);
+
+    /**
+     * @brief 解析内核cpulist格式，如"0-3,8,10-11"
+     * @return 升序CPU编号，格式错误的片段被忽略
+     */
+    static std::vector<int> ParseCpuList(const std::string& text);
+
+    const std::vector<CpuInfo>& Cpus() const { return m_cpus; }
+
+    /// 可用CPU所在的NUMA节点数
+    size_t NodeCount() const;
+
+    /// CPU所属NUMA节点，未知CPU返回-1
+    int NodeOf(int cpu) const;
+
+    /**
+     * @brief 紧凑顺序
+     * @details 按节点、封装、物理核排序，同一物理核的超线程相邻，
+     *          前N个线程共享尽可能少的节点与缓存
+     */
+    std::vector<int> CompactOrder() const;
+
+    /**
+     * @brief 分散顺序
+     * @details 在各节点间轮转；节点内先铺满不同物理核，再使用超线程兄弟，
+     *          前N个线程获得尽可能多的内存带宽与物理核
+     */
+    std::vector<int> ScatterOrder() const;
+
+private:
+    std::vector<CpuInfo> m_cpus;  // 按CPU编号升序
+};
+
+/**
+ * @brief 将调用线程绑定到指定CPU（sched_setaffinity）
+ * @return 成功返回true
+ */
+bool PinCurrentThread(int cpu);
+
+/**
+ * @brief 调用线程当前运行的CPU（sched_getcpu），失败返回-1
+ */
+int CurrentCpu();
+
+} // namespace PoolTypeStructure
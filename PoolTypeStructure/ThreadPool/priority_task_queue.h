@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:多优先级、截止时间感知的任务队列
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "task.h"
+
+namespace PoolTypeStructure {
+
+/**
+ * @brief 任务优先级通道
+ */
+enum class TaskPriority : uint8_t {
+    Realtime = 0,   ///< 延迟敏感任务，优先调度
+    Normal = 1,     ///< 默认通道
+    Background = 2  ///< 批处理任务，受饥饿保护
+};
+
+/// 优先级通道数量
+constexpr size_t kTaskPriorityCount = 3;
+
+/**
+ * @brief 单个任务的调度参数
+ */
+struct TaskOptions {
+    using Clock = std::chrono::steady_clock;
+
+    TaskPriority priority = TaskPriority::Normal;  ///< 所属通道
+    Clock::time_point deadline = Clock::time_point::max(); ///< 截止时间，默认无
+
+    bool HasDeadline() const { return deadline != Clock::time_point::max(); }
+};
+
+/**
+ * @brief 多优先级任务队列
+ * @details 调度规则：
+ *          - 通道间严格按优先级：Realtime > Normal > Background
+ *          - 通道内截止时间最早者优先（EDF），无截止时间的任务排在其后并保持FIFO
+ *          - 饥饿保护：Background通道非空且连续被跳过kStarvationLimit次后，强制调度一次
+ *          非线程安全，由调用方加锁保护
+ */
+class PriorityTaskQueue final {
+public:
+    /// Background通道最多被连续跳过的次数
+    static constexpr uint32_t kStarvationLimit = 16;
+
+    bool Empty() const { return m_count == 0; }
+    size_t Size() const { return m_count; }
+
+    /// 指定通道内的任务数
+    size_t LaneSize(TaskPriority priority) const {
+        const Lane& lane = m_lanes[Index(priority)];
+        return lane.fifo.Size() + lane.deadlines.size();
+    }
+
+    /**
+     * @brief 入队
+     * @param[in] task 任务
+     * @param[in] options 优先级与截止时间
+     */
+    void Push(Task&& task, const TaskOptions& options = TaskOptions()) {
+        Lane& lane = m_lanes[Index(options.priority)];
+        if (options.HasDeadline()) {
+            lane.deadlines.push_back(DeadlineTask{options.deadline, m_sequence++, std::move(task)});
+            std::push_heap(lane.deadlines.begin(), lane.deadlines.end(), LaterDeadline());
+        } else {
+            lane.fifo.Push(std::move(task));
+        }
+        ++m_count;
+    }
+
+    /**
+     * @brief 按调度规则出队（调用方需保证非空）
+     * @param[out] priority 出队任务所属通道，可为空
+     */
+    Task Pop(TaskPriority* priority = nullptr) {
+        const size_t background = Index(TaskPriority::Background);
+        size_t selected = background;
+        for (size_t i = 0; i < kTaskPriorityCount; ++i) {
+            if (!m_lanes[i].Empty()) {
+                selected = i;
+                break;
+            }
+        }
+
+        if (selected != background && !m_lanes[background].Empty()) {
+            if (++m_backgroundSkips >= kStarvationLimit) {
+                selected = background;
+            }
+        }
+        if (selected == background) {
+            m_backgroundSkips = 0;
+        }
+
+        if (priority) {
+            *priority = static_cast<TaskPriority>(selected);
+        }
+        --m_count;
+        return m_lanes[selected].Pop();
+    }
+
+private:
+    struct DeadlineTask {
+        TaskOptions::Clock::time_point deadline;
+        uint64_t sequence;  // 截止时间相同时保持提交顺序
+        Task task;
+    };
+
+    /// 小顶堆比较器：截止时间晚（或序号大）者优先级低
+    struct LaterDeadline {
+        bool operator()(const DeadlineTask& lhs, const DeadlineTask& rhs) const {
+            if (lhs.deadline != rhs.deadline) {
+                return lhs.deadline > rhs.deadline;
+            }
+            return lhs.sequence > rhs.sequence;
+        }
+    };
+
+    struct Lane {
+        bool Empty() const { return fifo.Empty() && deadlines.empty(); }
+
+        Task Pop() {
+            if (!deadlines.empty()) {
+                std::pop_heap(deadlines.begin(), deadlines.end(), LaterDeadline());
+                Task task(std::move(deadlines.back().task));
+                deadlines.pop_back();
+                return task;
+            }
+            return fifo.Pop();
+        }
+
+        TaskRingBuffer fifo;                  // 无截止时间任务
+        std::vector<DeadlineTask> deadlines;  // 截止时间小顶堆
+    };
+
+    static size_t Index(TaskPriority priority) { return static_cast<size_t>(priority); }
+
+    std::array<Lane, kTaskPriorityCount> m_lanes;
+    size_t m_count = 0;
+    uint64_t m_sequence = 0;
+    uint32_t m_backgroundSkips = 0;
+};
+
+} // namespace PoolTypeStructure
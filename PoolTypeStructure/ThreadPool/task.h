@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:小对象优化的只移动任务类型
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace PoolTypeStructure {
+
+/**
+ * @brief 只移动的任务对象（void()可调用体）
+ * @details 与std::function相比：
+ *          - 内联存储kInlineSize字节，小型lambda提交时零堆分配
+ *          - 只要求可调用体可移动，可直接持有std::packaged_task等只移动类型
+ *          - 超出内联容量或移动构造可能抛异常的可调用体退化为堆存储
+ *          整个对象恰好占用一条64字节缓存行（入队时间戳占用原有的对齐填充）
+ */
+class Task final {
+public:
+    /// 内联存储容量
+    static constexpr size_t kInlineSize = 48;
+
+    Task() noexcept = default;
+
+    /**
+     * @brief 由任意可调用对象构造
+     * @tparam F 可调用对象类型，签名需兼容void()
+     */
+    template <typename F,
+              typename D = typename std::decay<F>::type,
+              typename = typename std::enable_if<!std::is_same<D, Task>::value>::type>
+    Task(F&& func) {  // NOLINT: 允许隐式转换，便于直接传入lambda
+        if constexpr (FitsInline<D>()) {
+            ::new (static_cast<void*>(m_storage)) D(std::forward<F>(func));
+            m_vtable = &InlineVTable<D>::value;
+        } else {
+            D* heap = new D(std::forward<F>(func));
+            ::new (static_cast<void*>(m_storage)) D*(heap);
+            m_vtable = &HeapVTable<D>::value;
+        }
+    }
+
+    Task(Task&& other) noexcept
+        : m_vtable(other.m_vtable), m_enqueueTime(other.m_enqueueTime) {
+        if (m_vtable) {
+            m_vtable->move(m_storage, other.m_storage);
+            other.m_vtable = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            if (other.m_vtable) {
+                other.m_vtable->move(m_storage, other.m_storage);
+                m_vtable = other.m_vtable;
+                other.m_vtable = nullptr;
+            }
+            m_enqueueTime = other.m_enqueueTime;
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { Reset(); }
+
+    /// 是否持有可调用体
+    explicit operator bool() const noexcept { return m_vtable != nullptr; }
+
+    /// 执行任务（调用方需保证非空）
+    void operator()() { m_vtable->invoke(m_storage); }
+
+    /// 释放持有的可调用体
+    void Reset() noexcept {
+        if (m_vtable) {
+            m_vtable->destroy(m_storage);
+            m_vtable = nullptr;
+        }
+    }
+
+    /// 入队时间戳（steady_clock纳秒），0表示未记录；随任务一起移动
+    int64_t EnqueueTime() const noexcept { return m_enqueueTime; }
+    void SetEnqueueTime(int64_t ns) noexcept { m_enqueueTime = ns; }
+
+private:
+    struct VTable {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename D>
+    static constexpr bool FitsInline() {
+        return sizeof(D) <= kInlineSize &&
+               alignof(D) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<D>::value;
+    }
+
+    /// 内联存储：可调用体直接构造在m_storage中
+    template <typename D>
+    struct InlineVTable {
+        static void Invoke(void* storage) { (*static_cast<D*>(storage))(); }
+        static void Move(void* dst, void* src) noexcept {
+            D* from = static_cast<D*>(src);
+            ::new (dst) D(std::move(*from));
+            from->~D();
+        }
+        static void Destroy(void* storage) noexcept { static_cast<D*>(storage)->~D(); }
+        static constexpr VTable value{&Invoke, &Move, &Destroy};
+    };
+
+    /// 堆存储：m_storage中仅保存指针
+    template <typename D>
+    struct HeapVTable {
+        static D*& Ptr(void* storage) { return *static_cast<D**>(storage); }
+        static void Invoke(void* storage) { (*Ptr(storage))(); }
+        static void Move(void* dst, void* src) noexcept {
+            ::new (dst) D*(Ptr(src));
+            Ptr(src) = nullptr;
+        }
+        static void Destroy(void* storage) noexcept { delete Ptr(storage); }
+        static constexpr VTable value{&Invoke, &Move, &Destroy};
+    };
+
+    alignas(std::max_align_t) unsigned char m_storage[kInlineSize];
+    const VTable* m_vtable = nullptr;
+    int64_t m_enqueueTime = 0;
+};
+
+/**
+ * @brief 可增长的任务环形缓冲区
+ * @details 替代std::queue<std::deque>：容量只增不减，稳定状态下入队出队零堆分配。
+ *          非线程安全，由调用方加锁保护
+ */
+class TaskRingBuffer final {
+public:
+    explicit TaskRingBuffer(size_t capacity = 256) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        m_slots.resize(cap);
+    }
+
+    bool Empty() const { return m_count == 0; }
+    size_t Size() const { return m_count; }
+
+    /// 尾部入队，容量不足时扩容为两倍
+    void Push(Task&& task) {
+        if (m_count == m_slots.size()) {
+            Grow();
+        }
+        m_slots[(m_head + m_count) & (m_slots.size() - 1)] = std::move(task);
+        ++m_count;
+    }
+
+    /// 头部出队（调用方需保证非空）
+    Task Pop() {
+        Task task(std::move(m_slots[m_head]));
+        m_head = (m_head + 1) & (m_slots.size() - 1);
+        --m_count;
+        return task;
+    }
+
+private:
+    void Grow() {
+        std::vector<Task> slots(m_slots.size() * 2);
+        for (size_t i = 0; i < m_count; ++i) {
+            slots[i] = std::move(m_slots[(m_head + i) & (m_slots.size() - 1)]);
+        }
+        m_slots.swap(slots);
+        m_head = 0;
+    }
+
+    std::vector<Task> m_slots;
+    size_t m_head = 0;
+    size_t m_count = 0;
+};
+
+} // namespace PoolTypeStructure
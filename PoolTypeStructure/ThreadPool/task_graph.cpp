@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:基于依赖计数的任务图（DAG）
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+
+#include <atomic>
+#include <stdexcept>
+
+#include "task_graph.h"
+#include "thread_pool.h"
+
+namespace PoolTypeStructure {
+
+/// 单次运行的共享状态，由该次运行的所有节点任务共同持有
+struct TaskGraph::RunState {
+    RunState(TaskGraph& g, ThreadPool& p)
+        : graph(g), pool(p), pending(new std::atomic<size_t>[g.m_nodes.size()]),
+          failed(false), latch(g.m_nodes.size()) {
+        for (size_t i = 0; i < graph.m_nodes.size(); ++i) {
+            pending[i].store(graph.m_nodes[i].predecessors, std::memory_order_relaxed);
+        }
+    }
+
+    TaskGraph& graph;
+    ThreadPool& pool;
+    std::unique_ptr<std::atomic<size_t>[]> pending;  // 各节点剩余未完成的前驱数
+    std::atomic<bool> failed;                        // 是否已有节点抛出异常
+    CountDownLatch latch;                            // 所有节点结束时归零
+};
+
+void TaskGraph::AddDependency(NodeId before, NodeId after) {
+    if (before >= m_nodes.size() || after >= m_nodes.size()) {
+        throw std::out_of_range("Task graph node does not exist");
+    }
+    if (before == after) {
+        throw std::invalid_argument("Task graph node cannot depend on itself");
+    }
+    m_nodes[before].successors.push_back(after);
+    ++m_nodes[after].predecessors;
+}
+
+std::shared_ptr<CountDownLatch> TaskGraph::Run(ThreadPool& pool) {
+    if (!IsAcyclic()) {
+        throw std::invalid_argument("Task graph contains a cycle");
+    }
+
+    auto state = std::make_shared<RunState>(*this, pool);
+    std::vector<Task> roots;
+    for (NodeId id = 0; id < m_nodes.size(); ++id) {
+        if (m_nodes[id].predecessors == 0) {
+            roots.emplace_back([state, id]() { Execute(state, id); });
+        }
+    }
+    // 所有根节点一次加锁入队；线程池已关闭时整体失败，不会留下半次运行
+    pool.EnqueueBatch(roots);
+
+    // 门闩与运行状态共享生命周期
+    return std::shared_ptr<CountDownLatch>(state, &state->latch);
+}
+
+void TaskGraph::Execute(const std::shared_ptr<RunState>& state, NodeId id) {
+    constexpr NodeId kNone = static_cast<NodeId>(-1);
+
+    while (true) {
+        Node& node = state->graph.m_nodes[id];
+        std::exception_ptr error;
+        if (!state->failed.load(std::memory_order_relaxed)) {
+            try {
+                node.body();
+            } catch (...) {
+                error = std::current_exception();
+                state->failed.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        // 依赖计数归零的后继：第一个在本线程继续执行，其余交给线程池
+        NodeId next = kNone;
+        for (NodeId successor : node.successors) {
+            if (state->pending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (next == kNone) {
+                    next = successor;
+                } else {
+                    state->pool.Post([state, successor]() { Execute(state, successor); });
+                }
+            }
+        }
+
+        // 仍有后继待执行时门闩不会归零，之后访问图是安全的
+        state->latch.CountDown(error);
+        if (next == kNone) {
+            return;
+        }
+        id = next;
+    }
+}
+
+bool TaskGraph::IsAcyclic() const {
+    std::vector<size_t> indegree(m_nodes.size());
+    std::vector<NodeId> ready;
+    for (NodeId id = 0; id < m_nodes.size(); ++id) {
+        indegree[id] = m_nodes[id].predecessors;
+        if (indegree[id] == 0) {
+            ready.push_back(id);
+        }
+    }
+
+    size_t visited = 0;
+    while (!ready.empty()) {
+        const NodeId id = ready.back();
+        ready.pop_back();
+        ++visited;
+        for (NodeId successor : m_nodes[id].successors) {
+            if (--indegree[successor] == 0) {
+                ready.push_back(successor);
+            }
+        }
+    }
+    return visited == m_nodes.size();
+}
+
+} // namespace PoolTypeStructure
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:基于依赖计数的任务图（DAG）
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "count_down_latch.h"
+#include "task.h"
+
+namespace PoolTypeStructure {
+
+class ThreadPool;
+
+/**
+ * @brief 任务图
+ * @details 先构建节点与依赖，再提交到线程池执行：
+ *          - 每次运行为每个节点维护一个原子依赖计数，前驱完成时递减，
+ *            归零的后继直接调度，任何工作线程都不会阻塞等待前驱
+ *          - 同时就绪的多个后继中，第一个在当前线程上继续执行，其余提交到线程池
+ *          - 某个节点抛出异常后，尚未开始的节点跳过执行体，但依赖照常传播，
+ *            门闩最终归零并在Wait时重新抛出第一个异常
+ *          构建接口非线程安全；同一张图可重复运行，但一次运行结束前不得修改、销毁或再次运行
+ */
+class TaskGraph final {
+public:
+    using NodeId = size_t;
+
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+    TaskGraph(TaskGraph&&) = default;
+    TaskGraph& operator=(TaskGraph&&) = default;
+
+    /**
+     * @brief 添加节点
+     * @tparam F 可调用对象类型，签名兼容void()
+     * @param[in] func 节点执行体，每次运行调用一次
+     * @return 节点编号
+     */
+    template <typename F>
+    NodeId AddNode(F&& func) {
+        m_nodes.emplace_back(Task(std::forward<F>(func)));
+        return m_nodes.size() - 1;
+    }
+
+    /**
+     * @brief 声明依赖：after在before完成后才开始
+     * @exception std::out_of_range 节点编号不存在时抛出
+     * @exception std::invalid_argument before与after相同时抛出
+     */
+    void AddDependency(NodeId before, NodeId after);
+
+    /**
+     * @brief 添加一个在before完成后执行的节点（延续）
+     * @return 新节点编号
+     */
+    template <typename F>
+    NodeId Then(NodeId before, F&& func) {
+        const NodeId after = AddNode(std::forward<F>(func));
+        AddDependency(before, after);
+        return after;
+    }
+
+    /// 节点数
+    size_t Size() const { return m_nodes.size(); }
+
+    /**
+     * @brief 在线程池上运行整张图（不阻塞）
+     * @param[in] pool 执行所用的线程池
+     * @return std::shared_ptr<CountDownLatch> 所有节点结束时归零的门闩，
+     *         Wait()会重新抛出第一个节点异常
+     * @exception std::invalid_argument 图中存在环时抛出
+     * @exception std::runtime_error 线程池已关闭时抛出
+     * @note 不要在本线程池的工作线程中Wait：该线程被阻塞期间无法参与执行
+     */
+    std::shared_ptr<CountDownLatch> Run(ThreadPool& pool);
+
+private:
+    struct Node {
+        explicit Node(Task&& func) : body(std::move(func)) {}
+
+        Task body;                      // 执行体
+        std::vector<NodeId> successors; // 后继节点
+        size_t predecessors = 0;        // 前驱个数
+    };
+
+    struct RunState;
+
+    /// 执行节点及沿途就绪的首个后继
+    static void Execute(const std::shared_ptr<RunState>& state, NodeId id);
+
+    /// Kahn算法检查是否有环
+    bool IsAcyclic() const;
+
+    std::vector<Node> m_nodes;
+};
+
+} // namespace PoolTypeStructure
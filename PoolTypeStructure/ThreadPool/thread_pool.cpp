@@ -9,23 +9,128 @@
  * Author:LiangHuDream
  */
 
+#include <algorithm>
 #include <iostream>
+#include <map>
+#include <system_error>
 
 #include "thread_pool.h"
 
 namespace PoolTypeStructure {
 
+thread_local ThreadPool* ThreadPool::s_currentPool = nullptr;
+thread_local size_t ThreadPool::s_currentIndex = 0;
+
+struct ThreadPool::TaskNode {
+    Task task;
+    TaskNode* next = nullptr;
+};
+
+/// 线程私有的空闲节点链表，线程退出时释放
+struct ThreadPool::TaskNodeCache {
+    /// 单个线程最多缓存的空闲节点数，超出部分直接释放
+    static constexpr size_t kMaxCachedNodes = 4096;
+
+    ~TaskNodeCache() {
+        while (head) {
+            TaskNode* node = head;
+            head = head->next;
+            delete node;
+        }
+    }
+
+    TaskNode* head = nullptr;
+    size_t count = 0;
+};
+
+ThreadPool::TaskNodeCache& ThreadPool::LocalNodeCache() {
+    thread_local TaskNodeCache cache;
+    return cache;
+}
+
+ThreadPool::TaskNode* ThreadPool::AcquireNode(Task&& task) {
+    TaskNodeCache& cache = LocalNodeCache();
+    TaskNode* node = cache.head;
+    if (node) {
+        cache.head = node->next;
+        --cache.count;
+    } else {
+        node = new TaskNode;
+    }
+    node->task = std::move(task);
+    return node;
+}
+
+void ThreadPool::ReleaseNode(TaskNode* node) {
+    node->task.Reset();
+    TaskNodeCache& cache = LocalNodeCache();
+    if (cache.count >= TaskNodeCache::kMaxCachedNodes) {
+        delete node;
+        return;
+    }
+    node->next = cache.head;
+    cache.head = node;
+    ++cache.count;
+}
+
+ThreadPool::Worker::~Worker() {
+    // 正常关闭时队列已排空，此处仅处理构造失败等异常路径
+    TaskHandle task = nullptr;
+    while (deque.Pop(task)) {
+        delete task;
+    }
+}
+
+uint64_t ThreadPool::Worker::NextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
 ThreadPool::ThreadPool(size_t threadNum)
-    : m_taskQueue(std::make_unique<TaskQueue>()), m_isShutdown(false),
-      m_activeThreadCount(0) {
-  if (threadNum == 0) {
+    : ThreadPool(ThreadPoolOptions{threadNum, SchedulingMode::SingleQueue}) {}
+
+ThreadPool::ThreadPool(const ThreadPoolOptions& options)
+    : m_mode(options.mode), m_isShutdown(false), m_activeThreadCount(0),
+      m_options(options),
+      m_minThreads(options.minThreads ? options.minThreads : options.threadNum),
+      m_maxThreads(options.maxThreads ? options.maxThreads : options.threadNum),
+      m_dynamic(m_maxThreads > m_minThreads) {
+  if (options.threadNum == 0) {
     throw std::invalid_argument("Thread number cannot be zero");
   }
+  if (m_minThreads > options.threadNum || m_maxThreads < options.threadNum) {
+    throw std::invalid_argument(
+        "Thread bounds must satisfy minThreads <= threadNum <= maxThreads");
+  }
+
+  m_metrics.reset(new WorkerMetrics[m_maxThreads]);
+  m_spinners.reset(new AdaptiveSpinner[m_maxThreads]);
+  for (size_t i = 0; i < m_maxThreads; ++i) {
+    m_spinners[i] = AdaptiveSpinner(options.maxSpin);
+  }
+  InitPlacement(options);
+
+  if (m_mode == SchedulingMode::WorkStealing) {
+    m_workers.reserve(m_maxThreads);
+    for (size_t i = 0; i < m_maxThreads; ++i) {
+      m_workers.emplace_back(std::make_unique<Worker>(i));
+    }
+  }
 
   try {
-    m_workerThreads.reserve(threadNum);
-    for (size_t i = 0; i < threadNum; ++i) {
-      m_workerThreads.emplace_back(&ThreadPool::WorkerThreadProc, this);
+    m_workerThreads.resize(m_maxThreads);
+    m_threadExited.reset(new std::atomic<bool>[m_maxThreads]());
+    std::lock_guard<std::mutex> lock(m_resizeMutex);
+    for (size_t i = 0; i < options.threadNum; ++i) {
+      if (!StartWorker(i)) {
+        throw std::system_error(std::make_error_code(std::errc::resource_unavailable_try_again),
+                                "Failed to start worker thread");
+      }
+    }
+    if (m_dynamic) {
+      m_monitorThread = std::thread(&ThreadPool::MonitorThreadProc, this);
     }
   } catch (...) {
     Shutdown();
@@ -35,13 +140,86 @@ ThreadPool::ThreadPool(size_t threadNum)
 
 ThreadPool::~ThreadPool() { Shutdown(); }
 
+void ThreadPool::InitPlacement(const ThreadPoolOptions& options) {
+    m_slotQueue.assign(m_maxThreads, 0);
+    size_t queueCount = 1;
+
+    AffinityPolicy policy = options.affinity;
+    if (options.numaAware && policy == AffinityPolicy::None) {
+        policy = AffinityPolicy::Scatter;
+    }
+    if (policy != AffinityPolicy::None) {
+        const CpuTopology topology = CpuTopology::Detect();
+        std::vector<int> order;
+        switch (policy) {
+        case AffinityPolicy::Compact:
+            order = topology.CompactOrder();
+            break;
+        case AffinityPolicy::Scatter:
+            order = topology.ScatterOrder();
+            break;
+        default:
+            order = options.cpuList;
+            if (order.empty()) {
+                throw std::invalid_argument("Explicit affinity requires a non-empty CPU list");
+            }
+            for (int cpu : order) {
+                if (topology.NodeOf(cpu) < 0) {
+                    throw std::invalid_argument("CPU " + std::to_string(cpu) +
+                                                " is not available to this process");
+                }
+            }
+            break;
+        }
+
+        m_slotCpu.resize(m_maxThreads);
+        for (size_t i = 0; i < m_maxThreads; ++i) {
+            m_slotCpu[i] = order[i % order.size()];
+        }
+
+        // 只为有工作线程的节点建立队列；没有工作线程的节点上的提交方按CPU编号分摊
+        if (options.numaAware) {
+            std::map<int, size_t> nodeQueue;
+            for (size_t i = 0; i < m_maxThreads; ++i) {
+                const int node = topology.NodeOf(m_slotCpu[i]);
+                m_slotQueue[i] = nodeQueue.emplace(node, nodeQueue.size()).first->second;
+            }
+            queueCount = nodeQueue.size();
+
+            const int maxCpu = topology.Cpus().back().cpu;
+            m_cpuQueue.assign(static_cast<size_t>(maxCpu) + 1, 0);
+            for (const CpuInfo& info : topology.Cpus()) {
+                auto it = nodeQueue.find(info.node);
+                m_cpuQueue[info.cpu] = it != nodeQueue.end()
+                                           ? it->second
+                                           : static_cast<size_t>(info.cpu) % queueCount;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < queueCount; ++i) {
+        m_taskQueues.emplace_back(std::make_unique<TaskQueue>());
+    }
+}
+
 void ThreadPool::Shutdown() noexcept {
     bool expected = false;
     if (m_isShutdown.compare_exchange_strong(expected, true)) {
-        // 通知所有线程处理剩余任务
-        m_taskQueue->condition.notify_all();
+        // 先获取一次锁，保证休眠线程不会错过关闭通知；再通知所有线程处理剩余任务
+        for (auto& queue : m_taskQueues) {
+            { std::lock_guard<std::mutex> lock(queue->mutex); }
+            queue->condition.notify_all();
+        }
 
-        // 等待所有工作线程退出
+        // 先停止监控线程，之后不会再有扩容
+        { std::lock_guard<std::mutex> lock(m_monitorMutex); }
+        m_monitorCondition.notify_all();
+        if (m_monitorThread.joinable()) {
+            m_monitorThread.join();
+        }
+
+        // 等待所有工作线程（含已回收未join的线程）退出
+        std::lock_guard<std::mutex> lock(m_resizeMutex);
         for (auto& thread : m_workerThreads) {
             if (thread.joinable()) {
                 thread.join();
@@ -50,48 +228,612 @@ void ThreadPool::Shutdown() noexcept {
     }
 }
 
-void ThreadPool::WorkerThreadProc() {
+size_t ThreadPool::GetThreadCount() const noexcept {
+    return m_activeThreadCount.load(std::memory_order_relaxed);
+}
+
+ThreadPoolStats ThreadPool::GetStats() const {
+    ThreadPoolStats stats;
+    stats.workers.reserve(m_maxThreads);
+    for (size_t i = 0; i < m_maxThreads; ++i) {
+        stats.workers.push_back(m_metrics[i].Snapshot());
+        stats.total += stats.workers.back();
+    }
+    stats.threadCount = GetThreadCount();
+    stats.queuedTasks = QueuedTasks();
+    for (const auto& worker : m_workers) {
+        stats.queuedTasks += worker->deque.Size();
+    }
+    return stats;
+}
+
+uint64_t ThreadPool::TotalTasksExecuted() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < m_maxThreads; ++i) {
+        total += m_metrics[i].tasksExecuted.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+int64_t ThreadPool::NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+size_t ThreadPool::SubmitQueue() const {
+    if (s_currentPool == this) {
+        return m_slotQueue[s_currentIndex];
+    }
+    if (m_taskQueues.size() == 1) {
+        return 0;
+    }
+    const int cpu = CurrentCpu();
+    return (cpu >= 0 && static_cast<size_t>(cpu) < m_cpuQueue.size()) ? m_cpuQueue[cpu] : 0;
+}
+
+size_t ThreadPool::QueuedTasks() const {
+    size_t total = 0;
+    for (const auto& queue : m_taskQueues) {
+        total += queue->size.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t ThreadPool::SleepingCount() const {
+    size_t total = 0;
+    for (const auto& queue : m_taskQueues) {
+        total += queue->sleeping.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void ThreadPool::StampTask(Task& task) const {
+    if (m_options.enableTiming) {
+        task.SetEnqueueTime(NowNs());
+    }
+}
+
+bool ThreadPool::StartWorker(size_t index) {
+    std::thread& thread = m_workerThreads[index];
+    if (thread.joinable()) {
+        thread.join();
+    }
+    m_threadExited[index].store(false, std::memory_order_relaxed);
+
+    // 先计数再启动，避免并发扩容超出上限
     m_activeThreadCount.fetch_add(1, std::memory_order_relaxed);
-    
+    try {
+        thread = std::thread(&ThreadPool::WorkerThreadProc, this, index);
+    } catch (...) {
+        m_activeThreadCount.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void ThreadPool::TryGrow() {
+    // 工作线程也可能触发扩容，使用try_lock避免与Shutdown中的join互相等待
+    std::unique_lock<std::mutex> lock(m_resizeMutex, std::try_to_lock);
+    if (!lock.owns_lock() || m_isShutdown.load(std::memory_order_acquire)) {
+        return;
+    }
+    if (m_activeThreadCount.load(std::memory_order_relaxed) >= m_maxThreads) {
+        return;
+    }
+
+    for (size_t i = 0; i < m_maxThreads; ++i) {
+        const bool vacant = !m_workerThreads[i].joinable() ||
+                            m_threadExited[i].load(std::memory_order_acquire);
+        if (vacant) {
+            StartWorker(i);
+            return;
+        }
+    }
+}
+
+void ThreadPool::MaybeGrowOnEnqueue() {
+    if (m_dynamic && QueuedTasks() >= m_options.growQueueDepth && ShouldGrow(false)) {
+        TryGrow();
+    }
+}
+
+bool ThreadPool::ShouldGrow(bool stalled) const {
+    if (SleepingCount() > 0 ||
+        m_activeThreadCount.load(std::memory_order_relaxed) >= m_maxThreads) {
+        return false;
+    }
+    return QueuedTasks() >= m_options.growQueueDepth ||
+           (stalled && HasPendingTask());
+}
+
+bool ThreadPool::TryRetire() {
+    size_t current = m_activeThreadCount.load(std::memory_order_relaxed);
+    while (current > m_minThreads) {
+        if (m_activeThreadCount.compare_exchange_weak(current, current - 1,
+                                                      std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::CanRetire() const {
+    return m_dynamic &&
+           m_activeThreadCount.load(std::memory_order_relaxed) > m_minThreads;
+}
+
+void ThreadPool::MonitorThreadProc() {
+    uint64_t lastExecuted = TotalTasksExecuted();
+    std::unique_lock<std::mutex> lock(m_monitorMutex);
+    while (!m_isShutdown.load(std::memory_order_acquire)) {
+        m_monitorCondition.wait_for(lock, m_options.growWaitThreshold);
+        if (m_isShutdown.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        // 一个周期内没有任何任务执行完毕，说明现有线程都阻塞在任务内部（如I/O）
+        const uint64_t executed = TotalTasksExecuted();
+        const bool stalled = (executed == lastExecuted);
+        lastExecuted = executed;
+        if (ShouldGrow(stalled)) {
+            TryGrow();
+        }
+    }
+}
+
+void ThreadPool::EnqueueTask(Task&& task, const TaskOptions& options) {
+    const bool internal = (s_currentPool == this);
+    if (m_isShutdown.load(std::memory_order_acquire) && !internal) {
+        throw std::runtime_error("Submit task on stopped thread pool");
+    }
+    StampTask(task);
+
+    // 工作窃取模式下，线程池内部提交的普通任务直接进入本地队列，无需加锁
+    const bool plain = options.priority == TaskPriority::Normal && !options.HasDeadline();
+    if (m_mode == SchedulingMode::WorkStealing && internal && plain) {
+        m_workers[s_currentIndex]->deque.Push(AcquireNode(std::move(task)));
+        NotifyIdleWorker();
+        return;
+    }
+
+    const size_t home = SubmitQueue();
+    TaskQueue& target = *m_taskQueues[home];
+    bool parked = false;
+    {
+        std::unique_lock<std::mutex> lock(target.mutex);
+        target.queue.Push(std::move(task), options);
+        target.PublishSize();
+        parked = target.sleeping.load(std::memory_order_relaxed) > 0;
+    }
+
+    // 只在有线程休眠时通知，自旋中的线程会自行取到任务
+    if (parked) {
+        target.condition.notify_one();
+    }
+    NotifyRemoteWorkers(home, 1);
+    MaybeGrowOnEnqueue();
+}
+
+void ThreadPool::EnqueueBatch(std::vector<Task>& tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+
+    const bool internal = (s_currentPool == this);
+    if (m_isShutdown.load(std::memory_order_acquire) && !internal) {
+        throw std::runtime_error("Submit task on stopped thread pool");
+    }
+    for (auto& task : tasks) {
+        StampTask(task);
+    }
+
+    if (m_mode == SchedulingMode::WorkStealing && internal) {
+        auto& deque = m_workers[s_currentIndex]->deque;
+        for (auto& task : tasks) {
+            deque.Push(AcquireNode(std::move(task)));
+        }
+        NotifyIdleWorkers(tasks.size());
+        return;
+    }
+
+    const size_t home = SubmitQueue();
+    TaskQueue& target = *m_taskQueues[home];
+    {
+        std::unique_lock<std::mutex> lock(target.mutex);
+        for (auto& task : tasks) {
+            target.queue.Push(std::move(task));
+        }
+        target.PublishSize();
+    }
+
+    NotifyWorkers(home, tasks.size());
+    MaybeGrowOnEnqueue();
+}
+
+void ThreadPool::NotifyWorkers(size_t queue, size_t count) {
+    // 休眠登记与入队在同一把锁内完成，锁外读取不会漏掉已休眠的线程
+    TaskQueue& target = *m_taskQueues[queue];
+    const size_t sleeping = target.sleeping.load(std::memory_order_relaxed);
+    if (sleeping > 0) {
+        if (count >= sleeping) {
+            target.condition.notify_all();
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                target.condition.notify_one();
+            }
+        }
+    }
+    NotifyRemoteWorkers(queue, count);
+}
+
+void ThreadPool::NotifyRemoteWorkers(size_t home, size_t count) {
+    if (m_taskQueues.size() == 1) {
+        return;
+    }
+
+    // 与休眠方的登记构成Dekker式同步：要么休眠方看到新任务，要么这里看到休眠方
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const size_t local = m_taskQueues[home]->sleeping.load(std::memory_order_relaxed);
+    if (local >= count) {
+        return;
+    }
+    count -= local;
+
+    for (size_t i = 1; i < m_taskQueues.size() && count > 0; ++i) {
+        TaskQueue& remote = *m_taskQueues[(home + i) % m_taskQueues.size()];
+        const size_t sleeping = remote.sleeping.load(std::memory_order_relaxed);
+        if (sleeping == 0) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(remote.mutex);
+        const size_t wake = std::min(sleeping, count);
+        for (size_t j = 0; j < wake; ++j) {
+            remote.condition.notify_one();
+        }
+        count -= wake;
+    }
+}
+
+void ThreadPool::WorkerThreadProc(size_t index) {
+    s_currentPool = this;
+    s_currentIndex = index;
+    bool retired = false;
+    if (!m_slotCpu.empty()) {
+        // 绑核失败（如CPU已被移出进程的cpuset）时继续以不绑核方式运行
+        PinCurrentThread(m_slotCpu[index]);
+    }
+    WorkerMetrics& metrics = m_metrics[index];
+    const bool timing = m_options.enableTiming;
+    int64_t idleSince = timing ? NowNs() : 0;
+
     while (true) {
-        auto task = FetchTask();
+        Task task = (m_mode == SchedulingMode::WorkStealing)
+                        ? FetchTaskStealing(index, retired)
+                        : FetchTask(index, retired);
         if (!task) break;
 
+        int64_t startedAt = 0;
+        if (timing) {
+            startedAt = NowNs();
+            WorkerMetrics::Add<int64_t>(metrics.idleNs, startedAt - idleSince);
+            if (task.EnqueueTime() != 0) {
+                metrics.RecordWait(startedAt - task.EnqueueTime());
+            }
+        }
+
         try {
             task();
         } catch (const std::exception& ex) {
             // 异常处理策略：
-            // 1. 记录异常日志
+            // 1. 记录异常日志并计数
             // 2. 维持线程继续运行
             // 3. 异常信息通过future传递
-            std::cerr << "[ERROR] Worker thread caught exception: " 
+            WorkerMetrics::Add<uint64_t>(metrics.exceptions, 1);
+            std::cerr << "[ERROR] Worker thread caught exception: "
                       << ex.what() << std::endl;
         } catch (...) {
-            std::cerr << "[ERROR] Worker thread caught unknown exception" 
+            WorkerMetrics::Add<uint64_t>(metrics.exceptions, 1);
+            std::cerr << "[ERROR] Worker thread caught unknown exception"
                       << std::endl;
         }
+
+        if (timing) {
+            idleSince = NowNs();
+            WorkerMetrics::Add<int64_t>(metrics.busyNs, idleSince - startedAt);
+        }
+        WorkerMetrics::Add<uint64_t>(metrics.tasksExecuted, 1);
+    }
+
+    if (timing) {
+        WorkerMetrics::Add<int64_t>(metrics.idleNs, NowNs() - idleSince);
     }
 
-    m_activeThreadCount.fetch_sub(1, std::memory_order_relaxed);
+    // 被回收的线程已在TryRetire中扣减计数，只需标记槽位可复用
+    if (retired) {
+        m_threadExited[index].store(true, std::memory_order_release);
+    } else {
+        m_activeThreadCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+    s_currentPool = nullptr;
 }
 
-std::function<void()> ThreadPool::FetchTask() {
-    std::unique_lock<std::mutex> lock(m_taskQueue->mutex);
-    
-    // 修改等待条件：队列非空或关闭触发
-    m_taskQueue->condition.wait(lock, [this]() {
-        return !m_taskQueue->queue.empty() || m_isShutdown.load();
-    });
+Task ThreadPool::FetchTask(size_t index, bool& retired) {
+    const size_t home = m_slotQueue[index];
+    TaskQueue& local = *m_taskQueues[home];
+    AdaptiveSpinner& spinner = m_spinners[index];
+    int64_t idleSince = 0;
+    std::unique_lock<std::mutex> lock(local.mutex);
+
+    // 等待条件：队列非空或关闭触发；超出下限的线程空闲超时后回收
+    while (local.queue.Empty() && !m_isShutdown.load()) {
+        if (idleSince == 0) {
+            idleSince = NowNs();
+        }
+
+        // NUMA模式下本节点空闲时处理其他节点的任务，保证不会有任务无人处理
+        if (m_taskQueues.size() > 1) {
+            lock.unlock();
+            Task task = FetchRemoteTask(home);
+            if (task) {
+                spinner.RecordIdle(NowNs() - idleSince);
+                return task;
+            }
+            lock.lock();
+            if (!local.queue.Empty() || m_isShutdown.load()) {
+                break;
+            }
+        }
+
+        // 休眠前先自旋：任务密集到达时免去futex休眠与唤醒
+        lock.unlock();
+        const bool arrived = spinner.SpinUntil([this, &local, home]() {
+            return local.size.load(std::memory_order_relaxed) > 0 ||
+                   m_isShutdown.load(std::memory_order_relaxed) || HasRemoteTask(home);
+        });
+        lock.lock();
+        if (arrived) {
+            continue;
+        }
+
+        local.sleeping.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool timedOut = false;
+        if (!HasRemoteTask(home)) {
+            if (CanRetire()) {
+                timedOut = local.condition.wait_for(lock, m_options.keepAlive) ==
+                           std::cv_status::timeout;
+            } else {
+                local.condition.wait(lock);
+            }
+        }
+        local.sleeping.fetch_sub(1, std::memory_order_relaxed);
 
-    // 关闭且队列空时返回空任务
-    if (m_isShutdown.load() && m_taskQueue->queue.empty()) {
-        return nullptr;
+        if (timedOut && local.queue.Empty() && !m_isShutdown.load() &&
+            !HasRemoteTask(home) && TryRetire()) {
+            retired = true;
+            return Task();
+        }
+    }
+
+    // 关闭且队列空时处理其他节点的剩余任务，全部为空时返回空任务
+    if (m_isShutdown.load() && local.queue.Empty()) {
+        lock.unlock();
+        return FetchRemoteTask(home);
     }
 
     // 提取任务
-    auto task = std::move(m_taskQueue->queue.front());
-    m_taskQueue->queue.pop();
+    Task task = local.queue.Pop();
+    local.PublishSize();
+    if (idleSince != 0) {
+        spinner.RecordIdle(NowNs() - idleSince);
+    }
     return task;
 }
 
+Task ThreadPool::FetchRemoteTask(size_t home) {
+    for (size_t i = 1; i < m_taskQueues.size(); ++i) {
+        TaskQueue& remote = *m_taskQueues[(home + i) % m_taskQueues.size()];
+        if (remote.size.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(remote.mutex);
+        if (!remote.queue.Empty()) {
+            Task task = remote.queue.Pop();
+            remote.PublishSize();
+            return task;
+        }
+    }
+    return Task();
+}
+
+bool ThreadPool::HasRemoteTask(size_t home) const {
+    for (size_t i = 0; i < m_taskQueues.size(); ++i) {
+        if (i != home && m_taskQueues[i]->size.load(std::memory_order_relaxed) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Task ThreadPool::FetchTaskStealing(size_t index, bool& retired) {
+    Worker& self = *m_workers[index];
+    const size_t home = m_slotQueue[index];
+    AdaptiveSpinner& spinner = m_spinners[index];
+    int64_t idleSince = 0;
+
+    while (true) {
+        TaskHandle handle = nullptr;
+        // Realtime通道有积压时优先处理共享队列，避免排在本地任务之后
+        const bool urgent = m_taskQueues[home]->urgent.load(std::memory_order_relaxed) > 0;
+        bool found = (urgent && TryFetchGlobal(self, home, handle)) || self.deque.Pop(handle) ||
+                     TryFetchGlobal(self, home, handle) || TrySteal(self, handle);
+        // NUMA模式下最后才取其他节点共享队列中的任务
+        for (size_t i = 1; !found && i < m_taskQueues.size(); ++i) {
+            found = TryFetchGlobal(self, (home + i) % m_taskQueues.size(), handle);
+        }
+        if (found) {
+            if (idleSince != 0) {
+                spinner.RecordIdle(NowNs() - idleSince);
+            }
+            Task task(std::move(handle->task));
+            ReleaseNode(handle);
+            return task;
+        }
+
+        // 休眠前先自旋：任务密集到达时免去futex休眠与唤醒
+        if (idleSince == 0) {
+            idleSince = NowNs();
+        }
+        if (spinner.SpinUntil([this]() {
+                return HasPendingTask() || m_isShutdown.load(std::memory_order_relaxed);
+            }) && !m_isShutdown.load(std::memory_order_relaxed)) {
+            continue;
+        }
+
+        switch (WaitForWork(home)) {
+        case WaitResult::Work:
+            break;
+        case WaitResult::Retire:
+            retired = true;
+            return Task();
+        case WaitResult::Shutdown:
+            return Task();
+        }
+    }
+}
+
+bool ThreadPool::TryFetchGlobal(Worker& self, size_t queueIndex, TaskHandle& task) {
+    TaskQueue& shared = *m_taskQueues[queueIndex];
+    if (shared.size.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    size_t moved = 0;
+    {
+        std::unique_lock<std::mutex> lock(shared.mutex);
+        auto& queue = shared.queue;
+        if (queue.Empty()) {
+            return false;
+        }
+
+        task = AcquireNode(queue.Pop());
+
+        // 顺带搬运一批任务到本地队列，摊薄共享队列的加锁开销。
+        // Realtime任务不搬运；逆序压入使所有者按原调度顺序从底部弹出
+        if (queue.LaneSize(TaskPriority::Realtime) == 0) {
+            moved = std::min(queue.Size() / std::max<size_t>(GetThreadCount(), 1),
+                             kMaxGlobalBatch);
+        }
+        TaskHandle batch[kMaxGlobalBatch];
+        for (size_t i = 0; i < moved; ++i) {
+            batch[i] = AcquireNode(queue.Pop());
+        }
+        for (size_t i = moved; i > 0; --i) {
+            self.deque.Push(batch[i - 1]);
+        }
+        shared.PublishSize();
+    }
+
+    if (moved > 0) {
+        NotifyIdleWorker();
+    }
+    return true;
+}
+
+bool ThreadPool::TrySteal(Worker& self, TaskHandle& task) {
+    const size_t count = m_workers.size();
+    if (count < 2) {
+        return false;
+    }
+
+    // NUMA模式下第一轮只窃取同节点的线程，第二轮再跨节点窃取
+    const size_t home = m_slotQueue[self.index];
+    const size_t rounds = m_taskQueues.size() > 1 ? 2 : 1;
+    const size_t start = static_cast<size_t>(self.NextRandom() % count);
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < count; ++i) {
+            Worker& victim = *m_workers[(start + i) % count];
+            if (&victim == &self) continue;
+            if (rounds > 1 && (m_slotQueue[victim.index] == home) != (round == 0)) continue;
+
+            if (victim.deque.Steal(task)) {
+                WorkerMetrics::Add<uint64_t>(m_metrics[self.index].steals, 1);
+                // 目标队列仍有剩余时级联唤醒，避免只有一个窃取者在工作
+                if (!victim.deque.Empty()) {
+                    NotifyIdleWorker();
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::HasPendingTask() const {
+    if (QueuedTasks() > 0) {
+        return true;
+    }
+    for (const auto& worker : m_workers) {
+        if (!worker->deque.Empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ThreadPool::WaitResult ThreadPool::WaitForWork(size_t home) {
+    TaskQueue& local = *m_taskQueues[home];
+    std::unique_lock<std::mutex> lock(local.mutex);
+
+    // 先登记休眠再检查队列，与NotifyIdleWorker构成Dekker式同步，避免丢失唤醒
+    local.sleeping.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto ready = [this]() { return HasPendingTask() || m_isShutdown.load(); };
+    bool timedOut = false;
+    if (CanRetire()) {
+        timedOut = !local.condition.wait_for(lock, m_options.keepAlive, ready);
+    } else {
+        local.condition.wait(lock, ready);
+    }
+    local.sleeping.fetch_sub(1, std::memory_order_relaxed);
+
+    if (HasPendingTask()) {
+        return WaitResult::Work;
+    }
+    if (timedOut && TryRetire()) {
+        return WaitResult::Retire;
+    }
+    return m_isShutdown.load() ? WaitResult::Shutdown : WaitResult::Work;
+}
+
+void ThreadPool::NotifyIdleWorker() { NotifyIdleWorkers(1); }
+
+void ThreadPool::NotifyIdleWorkers(size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    // 从调用方所在节点开始唤醒，NUMA模式下优先唤醒同节点线程
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const size_t home = SubmitQueue();
+    for (size_t i = 0; i < m_taskQueues.size() && count > 0; ++i) {
+        TaskQueue& queue = *m_taskQueues[(home + i) % m_taskQueues.size()];
+        const size_t sleeping = queue.sleeping.load(std::memory_order_relaxed);
+        if (sleeping == 0) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (count >= sleeping) {
+            queue.condition.notify_all();
+        } else {
+            for (size_t j = 0; j < count; ++j) {
+                queue.condition.notify_one();
+            }
+        }
+        count -= std::min(count, sleeping);
+    }
+}
+
 } // namespace PoolTypeStructure
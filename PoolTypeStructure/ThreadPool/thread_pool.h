@@ -10,27 +10,96 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <vector>
-#include <queue>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <future>
 #include <functional>
 #include <atomic>
+#include <iterator>
 #include <memory>
+#include <tuple>
+#include <type_traits>
+
+#include "adaptive_spinner.h"
+#include "count_down_latch.h"
+#include "cpu_topology.h"
+#include "priority_task_queue.h"
+#include "task.h"
+#include "task_graph.h"
+#include "thread_pool_stats.h"
+#include "work_stealing_deque.h"
 
 namespace PoolTypeStructure {
 
+/**
+ * @brief 任务调度模式
+ */
+enum class SchedulingMode {
+    SingleQueue,  ///< 所有工作线程共享一个互斥量保护的任务队列
+    WorkStealing  ///< 每个工作线程持有无锁双端队列，空闲时随机窃取
+};
+
+/**
+ * @brief 工作线程绑核策略
+ */
+enum class AffinityPolicy {
+    None,     ///< 不绑核，由内核调度
+    Compact,  ///< 依次填满节点/物理核，超线程兄弟相邻（共享缓存优先）
+    Scatter,  ///< 在节点与物理核之间轮转（内存带宽优先）
+    Explicit  ///< 按ThreadPoolOptions::cpuList绑核
+};
+
+/**
+ * @brief 线程池构造参数
+ */
+struct ThreadPoolOptions {
+    size_t threadNum = std::thread::hardware_concurrency(); ///< 初始工作线程数量
+    SchedulingMode mode = SchedulingMode::SingleQueue;      ///< 调度模式
+
+    /// 动态伸缩参数：minThreads <= threadNum <= maxThreads，取0表示等于threadNum
+    size_t minThreads = 0;                                  ///< 空闲回收的下限
+    size_t maxThreads = 0;                                  ///< 扩容上限
+    size_t growQueueDepth = 64;                             ///< 无空闲线程且排队数达到该值时扩容
+    std::chrono::milliseconds growWaitThreshold{10};        ///< 无空闲线程且任务停滞超过该时长时扩容
+    std::chrono::milliseconds keepAlive{60000};             ///< 超出下限的线程空闲超过该时长后回收
+
+    /// 统计忙/闲时长与排队等待直方图，每个任务额外读取2~3次时钟；关闭后其余计数器照常累加
+    bool enableTiming = true;
+
+    /// 绑核与NUMA：线程槽位i绑定到策略顺序中的第(i % CPU数)个CPU
+    AffinityPolicy affinity = AffinityPolicy::None;         ///< 绑核策略
+    std::vector<int> cpuList;                               ///< Explicit策略使用的CPU编号
+    bool numaAware = false;                                 ///< 每个NUMA节点一个共享队列，未指定绑核策略时按Scatter绑核
+
+    /// 空闲线程休眠前的最长自旋时间（实际预算随任务到达间隔自适应），0表示不自旋
+    std::chrono::microseconds maxSpin{50};
+};
+
 /**
  * @brief 线程池管理类
  * @details 提供多线程任务调度能力，支持以下特性：
- *          - 固定数量工作线程
- *          - 自动任务分发
+ *          - 固定数量或按负载动态伸缩的工作线程
+ *          - 自动任务分发（单队列或工作窃取）
  *          - 优雅关闭机制
  *          - 任务结果追踪
+ *          - 无future的零分配提交（Post）
+ *          - 批量提交与并行循环（单次加锁、单个门闩）
+ *          - 优先级通道与截止时间调度
+ *          - 每线程无锁运行时统计（GetStats）
+ *          - 工作线程绑核与NUMA节点本地队列
+ *          - 任务图（TaskGraph）按依赖计数调度，无阻塞等待
  */
 class ThreadPool final {
+    // 任务图直接使用批量入队接口提交根节点
+    friend class TaskGraph;
+
+    template <typename T>
+    using IsTaskOptions = std::is_same<typename std::decay<T>::type, TaskOptions>;
+
 public:
     /**
      * @brief 构造函数
@@ -39,6 +108,21 @@ public:
      */
     explicit ThreadPool(size_t threadNum = std::thread::hardware_concurrency());
 
+    /**
+     * @brief 按构造参数创建线程池
+     * @param[in] options 线程数量、调度模式等参数
+     * @exception std::invalid_argument 当options.threadNum为0、线程数上下限不合法，
+     *            或Explicit策略的cpuList为空/含当前进程不可用的CPU时抛出
+     * @note numaAware时提交方把任务放入所在CPU节点的队列（工作线程提交放入其绑定节点），
+     *       工作线程优先处理本节点任务，本节点空闲时再处理其他节点的任务；
+     *       优先级与截止时间顺序只在单个节点的队列内保证
+     * @note maxThreads > minThreads时启动监控线程：无空闲线程且排队过深或任务停滞时扩容；
+     *       超出minThreads的线程空闲超过keepAlive后自行退出
+     * @note 工作窃取模式下，工作线程内部提交的任务进入该线程的本地队列，
+     *       外部线程提交的任务进入共享队列
+     */
+    explicit ThreadPool(const ThreadPoolOptions& options);
+
     /**
      * @brief 析构函数
      * @details 自动执行关闭操作并等待所有线程退出
@@ -54,11 +138,76 @@ public:
      * @return std::future<typename std::result_of<F(Args...)>::type> 任务执行结果句柄
      * @exception std::runtime_error 当线程池已关闭时抛出
      * @note 参数传递采用完美转发机制
+     * @note 关闭过程中，本线程池工作线程内部的提交仍被接受，保证在途任务的子任务得以执行
      */
-    template <typename F, typename... Args>
+    template <typename F, typename... Args,
+              typename = typename std::enable_if<!IsTaskOptions<F>::value>::type>
     auto SubmitTask(F&& task, Args&&... args) 
         -> std::future<typename std::result_of<F(Args...)>::type>;
 
+    /**
+     * @brief 按指定优先级/截止时间提交任务
+     * @param[in] options 任务调度参数
+     * @param[in] task 待执行的任务函数
+     * @param[in] args 任务参数列表
+     * @return 任务执行结果句柄
+     * @exception std::runtime_error 当线程池已关闭时抛出
+     * @note 非默认参数的任务总是进入共享队列，以保证通道间与通道内（EDF）的顺序
+     */
+    template <typename F, typename... Args>
+    auto SubmitTask(const TaskOptions& options, F&& task, Args&&... args)
+        -> std::future<typename std::result_of<F(Args...)>::type>;
+
+    /**
+     * @brief 提交无需结果的任务
+     * @tparam F 可调用对象类型
+     * @tparam Args 参数类型列表
+     * @param[in] task 待执行的任务函数
+     * @param[in] args 任务参数列表
+     * @exception std::runtime_error 当线程池已关闭时抛出
+     * @note 可调用体（含绑定参数）不超过Task::kInlineSize时不产生堆分配；
+     *       任务抛出的异常由工作线程捕获并记录
+     */
+    template <typename F, typename... Args,
+              typename = typename std::enable_if<!IsTaskOptions<F>::value>::type>
+    void Post(F&& task, Args&&... args);
+
+    /**
+     * @brief 按指定优先级/截止时间提交无需结果的任务
+     * @param[in] options 任务调度参数
+     * @param[in] task 待执行的任务函数
+     * @param[in] args 任务参数列表
+     * @exception std::runtime_error 当线程池已关闭时抛出
+     */
+    template <typename F, typename... Args>
+    void Post(const TaskOptions& options, F&& task, Args&&... args);
+
+    /**
+     * @brief 批量提交任务
+     * @tparam Range 可调用对象（签名void()）的区间类型，右值区间中的元素被移动
+     * @param[in] callables 待执行的任务集合
+     * @return std::shared_ptr<CountDownLatch> 全部任务完成时归零的门闩，
+     *         Wait()会重新抛出第一个任务异常
+     * @exception std::runtime_error 当线程池已关闭时抛出
+     * @note 整批任务在一次加锁内入队，并且最多唤醒min(任务数, 线程数)个工作线程
+     */
+    template <typename Range>
+    std::shared_ptr<CountDownLatch> SubmitBatch(Range&& callables);
+
+    /**
+     * @brief 并行执行循环 for (i = begin; i < end; ++i) func(i)
+     * @tparam Index 整数索引类型
+     * @tparam F 可调用对象类型，签名兼容void(Index)
+     * @param[in] begin 起始索引
+     * @param[in] end 结束索引（不含）
+     * @param[in] grain 每个分块的索引个数，小于1时按1处理
+     * @param[in] func 循环体
+     * @exception 所有分块结束后重新抛出第一个循环体异常
+     * @note 调用线程同样参与认领分块，因此可在本线程池的工作线程内嵌套调用
+     */
+    template <typename Index, typename F>
+    void ParallelFor(Index begin, Index end, Index grain, F&& func);
+
     /**
      * @brief 关闭线程池
      * @details 执行以下操作：
@@ -68,6 +217,19 @@ public:
      */
     void Shutdown() noexcept;
 
+    /**
+     * @brief 当前存活的工作线程数
+     */
+    size_t GetThreadCount() const noexcept;
+
+    /**
+     * @brief 获取运行时统计快照
+     * @details 无锁读取各工作线程的计数器，不会阻塞工作线程；
+     *          各计数器分别读取，并发执行时快照内部不保证严格一致
+     * @return ThreadPoolStats 按线程槽位划分的统计及其汇总
+     */
+    ThreadPoolStats GetStats() const;
+
 private:
     // 禁止拷贝和移动操作
     ThreadPool(const ThreadPool&) = delete;
@@ -82,57 +244,348 @@ private:
      *          2. 提取并执行任务
      *          3. 处理任务异常
      */
-    void WorkerThreadProc();
+    void WorkerThreadProc(size_t index);
+
+    /**
+     * @brief 计算各线程槽位绑定的CPU与所属共享队列
+     * @param[in] options 构造参数
+     * @exception std::invalid_argument Explicit策略的CPU列表不合法时抛出
+     */
+    void InitPlacement(const ThreadPoolOptions& options);
 
     /**
      * @brief 从任务队列提取任务
-     * @return std::function<void()> 待执行任务
-     * @retval 空函数对象表示无任务
+     * @param[in] index 当前工作线程编号
+     * @param[out] retired 线程因空闲超时被回收时置为true
+     * @return Task 待执行任务
+     * @retval 空任务表示无任务
+     */
+    Task FetchTask(size_t index, bool& retired);
+
+    /// 从其他节点的共享队列提取一个任务（NUMA模式下本节点空闲时调用）
+    Task FetchRemoteTask(size_t home);
+
+    /// 其他节点的共享队列是否有任务
+    bool HasRemoteTask(size_t home) const;
+
+    /**
+     * @brief 工作窃取模式下提取任务
+     * @details 依次尝试：本地队列 -> 共享队列 -> 随机窃取 -> 休眠等待
+     * @param[in] index 当前工作线程编号
+     * @param[out] retired 线程因空闲超时被回收时置为true
+     * @retval 空任务表示线程池已关闭且无剩余任务，或线程被回收
+     */
+    Task FetchTaskStealing(size_t index, bool& retired);
+
+    /// 动态伸缩：在空闲槽位上启动一个工作线程（调用方需持有m_resizeMutex）
+    bool StartWorker(size_t index);
+
+    /// 动态伸缩：条件满足时扩容一个线程，其他线程正在调整时直接放弃
+    void TryGrow();
+
+    /// 入队后的快速扩容检查（排队深度）
+    void MaybeGrowOnEnqueue();
+
+    /// 无空闲线程且排队过深或任务停滞时返回true
+    bool ShouldGrow(bool stalled) const;
+
+    /// 存活线程数高于下限时预订一次回收
+    bool TryRetire();
+
+    /// 是否允许当前空闲线程超时回收
+    bool CanRetire() const;
+
+    /// 监控线程：周期性检测任务停滞并扩容
+    void MonitorThreadProc();
+
+    /// 所有工作线程已执行完毕的任务数之和
+    uint64_t TotalTasksExecuted() const;
+
+    /// steady_clock当前时间（纳秒）
+    static int64_t NowNs();
+
+    /// 开启计时统计时记录任务入队时间
+    void StampTask(Task& task) const;
+
+    /**
+     * @brief 将任务放入队列并唤醒工作线程
+     * @param[in] task 已封装的任务
+     * @param[in] options 任务调度参数
+     * @exception std::runtime_error 当线程池已关闭且调用方不是本池工作线程时抛出
+     */
+    void EnqueueTask(Task&& task, const TaskOptions& options = TaskOptions());
+
+    /**
+     * @brief 一次加锁将整批任务入队，并唤醒所需数量的工作线程
+     * @param[in,out] tasks 待入队任务，入队后被移空
+     * @exception std::runtime_error 当线程池已关闭且调用方不是本池工作线程时抛出
+     */
+    void EnqueueBatch(std::vector<Task>& tasks);
+
+    /// 将批量任务包装为完成后递减门闩的Task
+    template <typename C>
+    static Task MakeBatchTask(const std::shared_ptr<CountDownLatch>& latch, C&& callable);
+
+    /// 唤醒至多count个在指定共享队列上等待的工作线程
+    void NotifyWorkers(size_t queue, size_t count);
+
+    /// NUMA模式下目标节点的休眠线程不足count个时，唤醒其他节点的休眠线程
+    void NotifyRemoteWorkers(size_t home, size_t count);
+
+    /// 调用线程提交任务时使用的共享队列
+    size_t SubmitQueue() const;
+
+    /// 所有共享队列的任务数之和
+    size_t QueuedTasks() const;
+
+    /// 所有共享队列上的休眠线程数之和
+    size_t SleepingCount() const;
+
+    /// 工作窃取模式下的任务节点，由线程私有缓存回收复用
+    struct TaskNode;
+    struct TaskNodeCache;
+    static TaskNodeCache& LocalNodeCache();
+    static TaskNode* AcquireNode(Task&& task);
+    static void ReleaseNode(TaskNode* node);
+
+    /// 工作窃取模式下的任务句柄（双端队列元素须可平凡拷贝）
+    using TaskHandle = TaskNode*;
+
+    /// 工作窃取模式下每个工作线程的私有状态
+    struct Worker {
+        explicit Worker(size_t idx) : index(idx), rngState(idx * 2654435761u + 1) {}
+        ~Worker();
+
+        /// xorshift随机数，用于选择窃取目标
+        uint64_t NextRandom();
+
+        WorkStealingDeque<TaskHandle> deque; // 本地无锁双端队列
+        size_t index;                        // 工作线程编号
+        uint64_t rngState;                   // 随机数状态
+    };
+
+    bool TryFetchGlobal(Worker& self, size_t queue, TaskHandle& task);
+    bool TrySteal(Worker& self, TaskHandle& task);
+    bool HasPendingTask() const;
+
+    /// 休眠等待结果
+    enum class WaitResult {
+        Work,      ///< 有任务可取
+        Shutdown,  ///< 关闭且无剩余任务
+        Retire     ///< 空闲超时，线程被回收
+    };
+
+    /**
+     * @brief 工作窃取模式下的休眠等待
+     * @param[in] home 当前工作线程所属的共享队列
      */
-    std::function<void()> FetchTask();
+    WaitResult WaitForWork(size_t home);
+
+    /// 存在休眠线程时唤醒其中一个
+    void NotifyIdleWorker();
 
-    /// 工作线程容器
+    /// 存在休眠线程时唤醒至多count个
+    void NotifyIdleWorkers(size_t count);
+
+    /// 工作线程容器（按maxThreads预留槽位）及槽位退出标志
     std::vector<std::thread> m_workerThreads;
+    std::unique_ptr<std::atomic<bool>[]> m_threadExited;
 
-    /// 任务队列及同步机制
+    /// 任务队列及同步机制（NUMA模式下每个节点一个）
     struct TaskQueue {
-        std::queue<std::function<void()>> queue; // 任务存储队列
+        PriorityTaskQueue queue;                // 任务存储队列（按优先级分通道）
         std::mutex mutex;                       // 队列访问互斥量
         std::condition_variable condition;      // 任务到达条件变量
+        std::atomic<size_t> size{0};            // 队列长度（锁内修改，锁外只读）
+        std::atomic<size_t> urgent{0};          // Realtime通道长度（锁内修改，锁外只读）
+        std::atomic<size_t> sleeping{0};        // 在该队列上休眠的线程数
+
+        /// 锁内调用，刷新锁外可见的长度
+        void PublishSize() {
+            size.store(queue.Size(), std::memory_order_relaxed);
+            urgent.store(queue.LaneSize(TaskPriority::Realtime), std::memory_order_relaxed);
+        }
     };
-    std::unique_ptr<TaskQueue> m_taskQueue;
+    std::vector<std::unique_ptr<TaskQueue>> m_taskQueues;
+
+    /// 线程槽位绑定的CPU（空表示不绑核）、所属共享队列，以及提交方CPU到共享队列的映射
+    std::vector<int> m_slotCpu;
+    std::vector<size_t> m_slotQueue;
+    std::vector<size_t> m_cpuQueue;
+
+    /// 工作窃取模式下的工作线程状态
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    SchedulingMode m_mode;
 
     /// 线程池状态控制
     std::atomic<bool> m_isShutdown;            // 关闭标志
-    std::atomic<size_t> m_activeThreadCount;    // 活跃线程计数
+    std::atomic<size_t> m_activeThreadCount;    // 活跃线程计数（含正在启动的线程）
+
+    /// 动态伸缩
+    ThreadPoolOptions m_options;
+    size_t m_minThreads;
+    size_t m_maxThreads;
+    bool m_dynamic;                             // maxThreads > minThreads
+    std::mutex m_resizeMutex;                   // 保护槽位分配与回收线程的join
+    std::thread m_monitorThread;
+    std::mutex m_monitorMutex;
+    std::condition_variable m_monitorCondition;
+
+    /// 按线程槽位划分的计数器，每个槽位独占缓存行
+    std::unique_ptr<WorkerMetrics[]> m_metrics;
+
+    /// 按线程槽位划分的自旋器，仅由所属工作线程访问
+    std::unique_ptr<AdaptiveSpinner[]> m_spinners;
+
+    /// 当前线程所属的线程池及工作线程编号，用于识别线程池内部提交
+    static thread_local ThreadPool* s_currentPool;
+    static thread_local size_t s_currentIndex;
+
+    /// 从共享队列一次搬运到本地队列的最大任务数
+    static constexpr size_t kMaxGlobalBatch = 32;
 };
 
 // 模板方法实现
-template <typename F, typename... Args>
+template <typename F, typename... Args, typename>
 auto ThreadPool::SubmitTask(F&& task, Args&&... args)
     -> std::future<typename std::result_of<F(Args...)>::type>
+{
+    return SubmitTask(TaskOptions(), std::forward<F>(task), std::forward<Args>(args)...);
+}
+
+template <typename F, typename... Args>
+auto ThreadPool::SubmitTask(const TaskOptions& options, F&& task, Args&&... args)
+    -> std::future<typename std::result_of<F(Args...)>::type>
 {
     using ReturnType = typename std::result_of<F(Args...)>::type;
 
-    if (m_isShutdown.load(std::memory_order_acquire)) {
-        throw std::runtime_error("Submit task on stopped thread pool");
+    // 可调用体与参数直接移入packaged_task，仅保留future共享状态一次分配
+    std::packaged_task<ReturnType()> taskWrapper(
+        [func = std::forward<F>(task),
+         argsTuple = std::make_tuple(std::forward<Args>(args)...)]() mutable -> ReturnType {
+            return std::apply(func, argsTuple);
+        });
+
+    // 获取future对象并存储任务（packaged_task只移动，可直接内联存入Task）
+    std::future<ReturnType> result = taskWrapper.get_future();
+    EnqueueTask(Task([wrapper = std::move(taskWrapper)]() mutable { wrapper(); }), options);
+    return result;
+}
+
+template <typename F, typename... Args, typename>
+void ThreadPool::Post(F&& task, Args&&... args)
+{
+    Post(TaskOptions(), std::forward<F>(task), std::forward<Args>(args)...);
+}
+
+template <typename F, typename... Args>
+void ThreadPool::Post(const TaskOptions& options, F&& task, Args&&... args)
+{
+    if constexpr (sizeof...(Args) == 0) {
+        EnqueueTask(Task(std::forward<F>(task)), options);
+    } else {
+        EnqueueTask(Task(
+            [func = std::forward<F>(task),
+             argsTuple = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                std::apply(func, argsTuple);
+            }), options);
+    }
+}
+
+template <typename Range>
+std::shared_ptr<CountDownLatch> ThreadPool::SubmitBatch(Range&& callables)
+{
+    const size_t count = static_cast<size_t>(
+        std::distance(std::begin(callables), std::end(callables)));
+    auto latch = std::make_shared<CountDownLatch>(count);
+
+    std::vector<Task> tasks;
+    tasks.reserve(count);
+    for (auto& callable : callables) {
+        // 右值区间移动元素，左值区间拷贝元素
+        if constexpr (std::is_lvalue_reference<Range>::value) {
+            tasks.emplace_back(MakeBatchTask(latch, callable));
+        } else {
+            tasks.emplace_back(MakeBatchTask(latch, std::move(callable)));
+        }
+    }
+
+    EnqueueBatch(tasks);
+    return latch;
+}
+
+template <typename C>
+Task ThreadPool::MakeBatchTask(const std::shared_ptr<CountDownLatch>& latch, C&& callable)
+{
+    return Task([latch, func = typename std::decay<C>::type(std::forward<C>(callable))]() mutable {
+        try {
+            func();
+            latch->CountDown();
+        } catch (...) {
+            latch->CountDown(std::current_exception());
+        }
+    });
+}
+
+template <typename Index, typename F>
+void ThreadPool::ParallelFor(Index begin, Index end, Index grain, F&& func)
+{
+    static_assert(std::is_integral<Index>::value, "ParallelFor index must be integral");
+    if (!(begin < end)) {
+        return;
     }
 
-    // 封装任务为共享指针，保证生命周期
-    auto taskWrapper = std::make_shared<std::packaged_task<ReturnType()>>(
-        std::bind(std::forward<F>(task), std::forward<Args>(args)...)
-    );
+    using Body = typename std::remove_reference<F>::type;
+    struct LoopState {
+        LoopState(Index b, Index e, size_t g, size_t n, Body* f)
+            : begin(b), end(e), grain(g), chunks(n), body(f), latch(n) {}
+
+        /// 认领并执行分块，直到所有分块都被认领
+        void Run() {
+            size_t chunk;
+            while ((chunk = next.fetch_add(1, std::memory_order_relaxed)) < chunks) {
+                const Index first = static_cast<Index>(begin + static_cast<Index>(chunk * grain));
+                const Index last = (static_cast<size_t>(end - first) > grain)
+                                       ? static_cast<Index>(first + static_cast<Index>(grain))
+                                       : end;
+                try {
+                    for (Index i = first; i < last; ++i) {
+                        (*body)(i);
+                    }
+                    latch.CountDown();
+                } catch (...) {
+                    latch.CountDown(std::current_exception());
+                }
+            }
+        }
 
-    // 获取future对象并存储任务
-    std::future<ReturnType> result = taskWrapper->get_future();
-    {
-        std::unique_lock<std::mutex> lock(m_taskQueue->mutex);
-        m_taskQueue->queue.emplace([taskWrapper](){ (*taskWrapper)(); });
+        Index begin;
+        Index end;
+        size_t grain;
+        size_t chunks;
+        Body* body;
+        std::atomic<size_t> next{0};
+        CountDownLatch latch;
+    };
+
+    const size_t chunkSize = grain < 1 ? 1 : static_cast<size_t>(grain);
+    const size_t total = static_cast<size_t>(end - begin);
+    const size_t chunks = (total + chunkSize - 1) / chunkSize;
+    auto state = std::make_shared<LoopState>(begin, end, chunkSize, chunks, &func);
+
+    // 调用线程自身处理一部分分块，只需为其余分块唤醒工作线程
+    const size_t helpers = std::min(chunks - 1, GetThreadCount());
+    if (helpers > 0) {
+        std::vector<Task> tasks;
+        tasks.reserve(helpers);
+        for (size_t i = 0; i < helpers; ++i) {
+            tasks.emplace_back([state]() { state->Run(); });
+        }
+        EnqueueBatch(tasks);
     }
 
-    // 通知等待线程
-    m_taskQueue->condition.notify_one();
-    return result;
+    state->Run();
+    state->latch.Wait();
 }
 
 } // namespace PoolTypeStructure
\ No newline at end of file
@@ -0,0 +1,263 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:线程池调度模式性能对比
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+using namespace PoolTypeStructure;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* ModeName(SchedulingMode mode) {
+    return mode == SchedulingMode::WorkStealing ? "work-stealing" : "single-queue";
+}
+
+void WaitFor(const std::atomic<size_t>& counter, size_t expected) {
+    while (counter.load(std::memory_order_acquire) < expected) {
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief 外部线程逐个提交空任务
+ * @return 每秒完成的任务数
+ */
+double BenchExternalSubmit(ThreadPool& pool, size_t tasks) {
+    std::atomic<size_t> done{0};
+    auto start = Clock::now();
+    for (size_t i = 0; i < tasks; ++i) {
+        pool.SubmitTask([&done]() { done.fetch_add(1, std::memory_order_release); });
+    }
+    WaitFor(done, tasks);
+    std::chrono::duration<double> used = Clock::now() - start;
+    return tasks / used.count();
+}
+
+/**
+ * @brief 外部线程逐个Post空任务（无future）
+ * @return 每秒完成的任务数
+ */
+double BenchExternalPost(ThreadPool& pool, size_t tasks) {
+    std::atomic<size_t> done{0};
+    auto start = Clock::now();
+    for (size_t i = 0; i < tasks; ++i) {
+        pool.Post([&done]() { done.fetch_add(1, std::memory_order_release); });
+    }
+    WaitFor(done, tasks);
+    std::chrono::duration<double> used = Clock::now() - start;
+    return tasks / used.count();
+}
+
+/**
+ * @brief 外部线程一次性批量提交空任务
+ * @return 每秒完成的任务数
+ */
+double BenchBatchSubmit(ThreadPool& pool, size_t tasks) {
+    std::vector<std::function<void()>> batch(tasks, []() {});
+    auto start = Clock::now();
+    pool.SubmitBatch(std::move(batch))->Wait();
+    std::chrono::duration<double> used = Clock::now() - start;
+    return tasks / used.count();
+}
+
+/**
+ * @brief 少量根任务在工作线程内部扇出子任务
+ * @return 每秒完成的子任务数
+ */
+double BenchNestedSpawn(ThreadPool& pool, size_t tasks, size_t roots) {
+    std::atomic<size_t> done{0};
+    const size_t perRoot = tasks / roots;
+    auto start = Clock::now();
+    for (size_t r = 0; r < roots; ++r) {
+        pool.Post([&pool, &done, perRoot]() {
+            for (size_t i = 0; i < perRoot; ++i) {
+                pool.Post([&done]() { done.fetch_add(1, std::memory_order_release); });
+            }
+        });
+    }
+    WaitFor(done, perRoot * roots);
+    std::chrono::duration<double> used = Clock::now() - start;
+    return perRoot * roots / used.count();
+}
+
+void BusyFor(std::chrono::microseconds duration) {
+    auto until = Clock::now() + duration;
+    while (Clock::now() < until) {
+    }
+}
+
+struct LatencySummary {
+    double p50Us;
+    double p99Us;
+};
+
+/**
+ * @brief 后台任务饱和时探测任务的排队延迟
+ * @param probePriority 探测任务所在通道
+ * @return 探测任务从提交到开始执行的p50/p99延迟
+ */
+LatencySummary BenchPriorityLatency(ThreadPool& pool, TaskPriority probePriority,
+                                    size_t backgroundTasks, size_t probes) {
+    // 返回时大部分后台任务还在队列里，停止标志要活得比它们久
+    auto stop = std::make_shared<std::atomic<bool>>(false);
+    for (size_t i = 0; i < backgroundTasks; ++i) {
+        pool.Post(TaskOptions{TaskPriority::Background}, [stop]() {
+            if (!stop->load(std::memory_order_relaxed)) {
+                BusyFor(std::chrono::microseconds(100));
+            }
+        });
+    }
+
+    std::vector<double> latencies(probes);
+    std::atomic<size_t> done{0};
+    for (size_t i = 0; i < probes; ++i) {
+        auto submitted = Clock::now();
+        pool.Post(TaskOptions{probePriority}, [&latencies, &done, submitted, i]() {
+            std::chrono::duration<double, std::micro> waited = Clock::now() - submitted;
+            latencies[i] = waited.count();
+            done.fetch_add(1, std::memory_order_release);
+        });
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    WaitFor(done, probes);
+    stop->store(true);
+
+    std::sort(latencies.begin(), latencies.end());
+    auto at = [&latencies](double q) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * q))];
+    };
+    return LatencySummary{at(0.50), at(0.99)};
+}
+
+/**
+ * @brief 分层DAG：第l层第i个节点依赖第l-1层的第i与第(i+1)%width个节点
+ * @return 每秒完成的节点数（含建图）
+ */
+double BenchTaskGraph(ThreadPool& pool, size_t layers, size_t width) {
+    auto start = Clock::now();
+    TaskGraph graph;
+    std::vector<TaskGraph::NodeId> prev;
+    std::vector<TaskGraph::NodeId> curr;
+    for (size_t l = 0; l < layers; ++l) {
+        curr.clear();
+        for (size_t i = 0; i < width; ++i) {
+            curr.push_back(graph.AddNode([]() {}));
+            if (l > 0) {
+                graph.AddDependency(prev[i], curr.back());
+                if (width > 1) {
+                    graph.AddDependency(prev[(i + 1) % width], curr.back());
+                }
+            }
+        }
+        prev.swap(curr);
+    }
+    graph.Run(pool)->Wait();
+    std::chrono::duration<double> used = Clock::now() - start;
+    return layers * width / used.count();
+}
+
+/**
+ * @brief 同一DAG的future实现：按拓扑序提交，节点在工作线程中阻塞get()前驱
+ * @return 每秒完成的节点数
+ */
+double BenchFutureGraph(ThreadPool& pool, size_t layers, size_t width) {
+    auto start = Clock::now();
+    std::vector<std::shared_future<void>> prev;
+    std::vector<std::shared_future<void>> curr;
+    for (size_t l = 0; l < layers; ++l) {
+        curr.clear();
+        for (size_t i = 0; i < width; ++i) {
+            if (l == 0) {
+                curr.push_back(pool.SubmitTask([]() {}).share());
+            } else {
+                auto lhs = prev[i];
+                auto rhs = prev[(i + 1) % width];
+                curr.push_back(pool.SubmitTask([lhs, rhs]() {
+                    lhs.get();
+                    rhs.get();
+                }).share());
+            }
+        }
+        prev.swap(curr);
+    }
+    for (auto& future : prev) {
+        future.get();
+    }
+    std::chrono::duration<double> used = Clock::now() - start;
+    return layers * width / used.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t tasks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    const size_t threadCounts[] = {1, 4, 16, 64};
+    const SchedulingMode modes[] = {SchedulingMode::SingleQueue,
+                                    SchedulingMode::WorkStealing};
+
+    std::printf("%-14s %8s %18s %18s %18s %18s\n", "mode", "threads",
+                "submit(task/s)", "post(task/s)", "batch(task/s)", "nested(task/s)");
+    for (size_t threads : threadCounts) {
+        for (SchedulingMode mode : modes) {
+            ThreadPool pool(ThreadPoolOptions{threads, mode});
+            double submit = BenchExternalSubmit(pool, tasks);
+            double post = BenchExternalPost(pool, tasks);
+            double batch = BenchBatchSubmit(pool, tasks);
+            double nested = BenchNestedSpawn(pool, tasks, threads);
+            std::printf("%-14s %8zu %18.0f %18.0f %18.0f %18.0f\n", ModeName(mode),
+                        threads, submit, post, batch, nested);
+        }
+    }
+
+    // 后台通道饱和时，Realtime探测任务相对同通道探测任务（等价于原FIFO队列）的排队延迟
+    std::printf("\n%-14s %8s %12s %12s %12s\n", "mode", "threads", "probe-lane",
+                "p50(us)", "p99(us)");
+    for (SchedulingMode mode : modes) {
+        for (TaskPriority lane : {TaskPriority::Background, TaskPriority::Realtime}) {
+            ThreadPool pool(ThreadPoolOptions{4, mode});
+            LatencySummary summary = BenchPriorityLatency(pool, lane, 4000, 200);
+            std::printf("%-14s %8d %12s %12.1f %12.1f\n", ModeName(mode), 4,
+                        lane == TaskPriority::Realtime ? "realtime" : "fifo",
+                        summary.p50Us, summary.p99Us);
+        }
+    }
+
+    // 宽/深DAG：依赖计数调度 vs 在工作线程中阻塞等待future
+    std::printf("\n%-14s %8s %12s %18s %18s\n", "mode", "threads", "dag(LxW)",
+                "graph(node/s)", "future(node/s)");
+    const size_t shapes[][2] = {{4, 5000}, {5000, 4}};
+    for (size_t threads : {4, 16}) {
+        for (SchedulingMode mode : modes) {
+            for (const auto& shape : shapes) {
+                ThreadPool pool(ThreadPoolOptions{threads, mode});
+                double graph = BenchTaskGraph(pool, shape[0], shape[1]);
+                double future = BenchFutureGraph(pool, shape[0], shape[1]);
+                char label[32];
+                std::snprintf(label, sizeof(label), "%zux%zu", shape[0], shape[1]);
+                std::printf("%-14s %8zu %12s %18.0f %18.0f\n", ModeName(mode), threads, label,
+                            graph, future);
+            }
+        }
+    }
+    return 0;
+}
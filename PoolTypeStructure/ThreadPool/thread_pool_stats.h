@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:线程池运行时统计
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PoolTypeStructure {
+
+/// 排队等待时间直方图的桶数
+constexpr size_t kWaitHistogramBuckets = 20;
+
+/**
+ * @brief 单个工作线程的统计快照
+ * @details waitHistogram按2的幂划分排队等待时间（微秒）：
+ *          桶0为[0, 1us)，桶i为[2^(i-1), 2^i)us，最后一个桶包含所有更长的等待
+ */
+struct WorkerStats {
+    uint64_t tasksExecuted = 0;                 ///< 已执行完毕的任务数
+    uint64_t steals = 0;                        ///< 从其他线程本地队列窃取成功的次数
+    uint64_t exceptions = 0;                    ///< 工作线程捕获的任务异常数
+    std::chrono::nanoseconds busyTime{0};       ///< 执行任务的累计时长
+    std::chrono::nanoseconds idleTime{0};       ///< 取任务/休眠的累计时长（不含当前空闲段）
+    std::array<uint64_t, kWaitHistogramBuckets> waitHistogram{}; ///< 排队等待时间分布
+
+    /// 桶index的上界（不含），最后一个桶返回max()
+    static std::chrono::microseconds BucketUpperBound(size_t index) {
+        if (index + 1 >= kWaitHistogramBuckets) {
+            return std::chrono::microseconds::max();
+        }
+        return std::chrono::microseconds(int64_t(1) << index);
+    }
+
+    /// 累加另一个快照
+    WorkerStats& operator+=(const WorkerStats& other) {
+        tasksExecuted += other.tasksExecuted;
+        steals += other.steals;
+        exceptions += other.exceptions;
+        busyTime += other.busyTime;
+        idleTime += other.idleTime;
+        for (size_t i = 0; i < kWaitHistogramBuckets; ++i) {
+            waitHistogram[i] += other.waitHistogram[i];
+        }
+        return *this;
+    }
+};
+
+/**
+ * @brief 线程池统计快照
+ */
+struct ThreadPoolStats {
+    std::vector<WorkerStats> workers;  ///< 按线程槽位编号（动态伸缩时槽位复用，计数累加）
+    WorkerStats total;                 ///< 所有槽位之和
+    size_t threadCount = 0;            ///< 当前存活的工作线程数
+    size_t queuedTasks = 0;            ///< 共享队列与各本地队列中的排队任务数（近似）
+};
+
+/**
+ * @brief 单个工作线程的计数器
+ * @details 仅由所属工作线程写入（单写者，load+store而非原子RMW），
+ *          其他线程随时可无锁读取；独占缓存行，避免工作线程之间的伪共享
+ */
+struct alignas(64) WorkerMetrics {
+    std::atomic<uint64_t> tasksExecuted{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> exceptions{0};
+    std::atomic<int64_t> busyNs{0};
+    std::atomic<int64_t> idleNs{0};
+    std::atomic<uint64_t> waitHistogram[kWaitHistogramBuckets] = {};
+
+    /// 单写者递增
+    template <typename T>
+    static void Add(std::atomic<T>& counter, T value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+    }
+
+    /// 记录一次排队等待
+    void RecordWait(int64_t waitNs) {
+        uint64_t us = waitNs > 0 ? static_cast<uint64_t>(waitNs) / 1000 : 0;
+        size_t bucket = 0;
+        while (us != 0 && bucket + 1 < kWaitHistogramBuckets) {
+            us >>= 1;
+            ++bucket;
+        }
+        Add<uint64_t>(waitHistogram[bucket], 1);
+    }
+
+    /// 读取快照（任意线程）
+    WorkerStats Snapshot() const {
+        WorkerStats stats;
+        stats.tasksExecuted = tasksExecuted.load(std::memory_order_relaxed);
+        stats.steals = steals.load(std::memory_order_relaxed);
+        stats.exceptions = exceptions.load(std::memory_order_relaxed);
+        stats.busyTime = std::chrono::nanoseconds(busyNs.load(std::memory_order_relaxed));
+        stats.idleTime = std::chrono::nanoseconds(idleNs.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < kWaitHistogramBuckets; ++i) {
+            stats.waitHistogram[i] = waitHistogram[i].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+};
+
+} // namespace PoolTypeStructure
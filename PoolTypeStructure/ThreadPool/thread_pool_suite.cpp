@@ -0,0 +1,400 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:线程池基准与压力测试套件（CSV/JSON输出，便于跟踪回归）
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+using namespace PoolTypeStructure;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// 一条测量结果
+struct Result {
+    std::string scenario;
+    std::string mode;
+    size_t threads;
+    std::string metric;
+    double value;
+    std::string unit;
+};
+
+/// 命令行参数
+struct Config {
+    std::vector<size_t> threads{1, 2, 4, 8, 16};
+    std::vector<SchedulingMode> modes{SchedulingMode::SingleQueue, SchedulingMode::WorkStealing};
+    size_t tasks = 100000;
+    std::string format = "csv";
+    std::string output;
+    std::string filter;
+};
+
+const char* ModeName(SchedulingMode mode) {
+    return mode == SchedulingMode::WorkStealing ? "work-stealing" : "single-queue";
+}
+
+double Seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void WaitFor(const std::atomic<size_t>& counter, size_t expected) {
+    while (counter.load(std::memory_order_acquire) < expected) {
+        std::this_thread::yield();
+    }
+}
+
+void BusyFor(std::chrono::nanoseconds duration) {
+    auto until = Clock::now() + duration;
+    while (Clock::now() < until) {
+    }
+}
+
+double Percentile(std::vector<double>& samples, double q) {
+    std::sort(samples.begin(), samples.end());
+    return samples[std::min(samples.size() - 1, static_cast<size_t>(samples.size() * q))];
+}
+
+/**
+ * @brief 场景：外部线程提交空任务的吞吐
+ */
+void EmptyTaskThroughput(ThreadPool& pool, const Config& config, std::vector<Result>& out,
+                         const Result& base) {
+    std::atomic<size_t> done{0};
+    auto start = Clock::now();
+    for (size_t i = 0; i < config.tasks; ++i) {
+        pool.Post([&done]() { done.fetch_add(1, std::memory_order_release); });
+    }
+    WaitFor(done, config.tasks);
+    Result row = base;
+    row.metric = "throughput";
+    row.value = config.tasks / Seconds(start);
+    row.unit = "task/s";
+    out.push_back(row);
+}
+
+/**
+ * @brief 场景：提交延迟
+ * @details 逐个提交并等待完成：enqueue为SubmitTask调用本身的耗时，
+ *          start为提交到开始执行的耗时（含唤醒）
+ */
+void SubmitLatency(ThreadPool& pool, const Config& config, std::vector<Result>& out,
+                   const Result& base) {
+    const size_t samples = std::max<size_t>(100, config.tasks / 100);
+    std::vector<double> enqueue(samples);
+    std::vector<double> startLatency(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        auto submitted = Clock::now();
+        auto future = pool.SubmitTask([]() { return Clock::now(); });
+        enqueue[i] = std::chrono::duration<double, std::nano>(Clock::now() - submitted).count();
+        startLatency[i] = std::chrono::duration<double, std::nano>(future.get() - submitted).count();
+    }
+
+    for (auto& entry : {std::make_pair("enqueue", &enqueue), std::make_pair("start", &startLatency)}) {
+        for (double q : {0.50, 0.99}) {
+            Result row = base;
+            row.metric = std::string(entry.first) + (q < 0.9 ? "_p50" : "_p99");
+            row.value = Percentile(*entry.second, q);
+            row.unit = "ns";
+            out.push_back(row);
+        }
+    }
+}
+
+/**
+ * @brief 场景：扇出/扇入
+ * @details 根任务在工作线程内扇出width个子任务，最后一个子任务完成时一轮结束
+ */
+void FanOutFanIn(ThreadPool& pool, const Config& config, std::vector<Result>& out,
+                 const Result& base) {
+    const size_t width = 256;
+    const size_t rounds = std::max<size_t>(10, config.tasks / width);
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        std::atomic<size_t> remaining{width};
+        std::atomic<size_t> roundDone{0};
+        pool.Post([&pool, &remaining, &roundDone, width]() {
+            for (size_t i = 0; i < width; ++i) {
+                pool.Post([&remaining, &roundDone]() {
+                    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        roundDone.store(1, std::memory_order_release);
+                    }
+                });
+            }
+        });
+        WaitFor(roundDone, 1);
+    }
+    const double used = Seconds(start);
+
+    Result row = base;
+    row.metric = "rounds";
+    row.value = rounds / used;
+    row.unit = "round/s";
+    out.push_back(row);
+    row.metric = "throughput";
+    row.value = rounds * width / used;
+    row.unit = "task/s";
+    out.push_back(row);
+}
+
+/**
+ * @brief 场景：生产者密集（多个外部线程同时提交空任务，入队竞争为瓶颈）
+ */
+void ProducerHeavy(ThreadPool& pool, const Config& config, std::vector<Result>& out,
+                   const Result& base) {
+    const size_t producers = 4;
+    const size_t perProducer = config.tasks / producers;
+    std::atomic<size_t> done{0};
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&pool, &done, perProducer]() {
+            for (size_t i = 0; i < perProducer; ++i) {
+                pool.Post([&done]() { done.fetch_add(1, std::memory_order_release); });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    WaitFor(done, perProducer * producers);
+
+    Result row = base;
+    row.metric = "throughput";
+    row.value = perProducer * producers / Seconds(start);
+    row.unit = "task/s";
+    out.push_back(row);
+}
+
+/**
+ * @brief 场景：消费者密集（单个生产者提交固定耗时任务，执行为瓶颈）
+ * @details 报告吞吐与并行效率（理想加速比下的占比）
+ */
+void ConsumerHeavy(ThreadPool& pool, const Config& config, std::vector<Result>& out,
+                   const Result& base) {
+    const auto work = std::chrono::microseconds(5);
+    const size_t tasks = std::max<size_t>(1000, config.tasks / 20);
+    std::atomic<size_t> done{0};
+    auto start = Clock::now();
+    for (size_t i = 0; i < tasks; ++i) {
+        pool.Post([&done, work]() {
+            BusyFor(work);
+            done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    WaitFor(done, tasks);
+    const double used = Seconds(start);
+
+    Result row = base;
+    row.metric = "throughput";
+    row.value = tasks / used;
+    row.unit = "task/s";
+    out.push_back(row);
+    // hardware_concurrency() 取不到时返回 0，并行度至少按 1 算
+    const size_t parallel = std::max<size_t>(
+        1, std::min<size_t>(base.threads, std::thread::hardware_concurrency()));
+    const double ideal = std::chrono::duration<double>(work).count() * tasks / parallel;
+    row.metric = "efficiency";
+    row.value = ideal / used;
+    row.unit = "ratio";
+    out.push_back(row);
+}
+
+/**
+ * @brief 场景：混合任务大小（90%空任务、9% 10us、1% 200us）
+ * @details 报告吞吐与线程池统计的排队等待p99
+ */
+void MixedSizes(ThreadPool& pool, const Config& config, std::vector<Result>& out,
+                const Result& base) {
+    const size_t tasks = std::max<size_t>(1000, config.tasks / 10);
+    std::atomic<size_t> done{0};
+    const WorkerStats before = pool.GetStats().total;
+    auto start = Clock::now();
+    for (size_t i = 0; i < tasks; ++i) {
+        std::chrono::nanoseconds work(0);
+        if (i % 100 == 0) {
+            work = std::chrono::microseconds(200);
+        } else if (i % 10 == 0) {
+            work = std::chrono::microseconds(10);
+        }
+        pool.Post([&done, work]() {
+            if (work.count() > 0) {
+                BusyFor(work);
+            }
+            done.fetch_add(1, std::memory_order_release);
+        });
+    }
+    WaitFor(done, tasks);
+    const double used = Seconds(start);
+
+    Result row = base;
+    row.metric = "throughput";
+    row.value = tasks / used;
+    row.unit = "task/s";
+    out.push_back(row);
+
+    // 由排队等待直方图估计p99（取所在桶的上界）
+    const WorkerStats after = pool.GetStats().total;
+    uint64_t total = 0;
+    for (size_t i = 0; i < kWaitHistogramBuckets; ++i) {
+        total += after.waitHistogram[i] - before.waitHistogram[i];
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kWaitHistogramBuckets && total > 0; ++i) {
+        seen += after.waitHistogram[i] - before.waitHistogram[i];
+        if (seen * 100 >= total * 99) {
+            row.metric = "wait_p99_upper";
+            row.value = static_cast<double>(WorkerStats::BucketUpperBound(i).count());
+            row.unit = "us";
+            out.push_back(row);
+            break;
+        }
+    }
+}
+
+struct Scenario {
+    const char* name;
+    void (*run)(ThreadPool&, const Config&, std::vector<Result>&, const Result&);
+};
+
+const Scenario kScenarios[] = {
+    {"empty_task", &EmptyTaskThroughput},
+    {"submit_latency", &SubmitLatency},
+    {"fan_out_fan_in", &FanOutFanIn},
+    {"producer_heavy", &ProducerHeavy},
+    {"consumer_heavy", &ConsumerHeavy},
+    {"mixed_sizes", &MixedSizes},
+};
+
+std::vector<size_t> ParseList(const char* text) {
+    std::vector<size_t> values;
+    for (const char* p = text; *p;) {
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(p, &end, 10);
+        if (end == p) break;
+        if (value > 0) values.push_back(static_cast<size_t>(value));
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return values;
+}
+
+void PrintUsage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [--threads 1,2,4] [--mode sq|ws|all] [--tasks N]\n"
+                 "          [--format csv|json] [--output FILE] [--filter SCENARIO]\n"
+                 "scenarios: empty_task submit_latency fan_out_fan_in producer_heavy\n"
+                 "           consumer_heavy mixed_sizes\n",
+                 program);
+}
+
+bool ParseArgs(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value) {
+            return false;
+        }
+        if (std::strcmp(arg, "--threads") == 0) {
+            config.threads = ParseList(value);
+        } else if (std::strcmp(arg, "--mode") == 0) {
+            if (std::strcmp(value, "sq") == 0) {
+                config.modes = {SchedulingMode::SingleQueue};
+            } else if (std::strcmp(value, "ws") == 0) {
+                config.modes = {SchedulingMode::WorkStealing};
+            } else if (std::strcmp(value, "all") != 0) {
+                return false;
+            }
+        } else if (std::strcmp(arg, "--tasks") == 0) {
+            config.tasks = std::strtoull(value, nullptr, 10);
+        } else if (std::strcmp(arg, "--format") == 0) {
+            config.format = value;
+        } else if (std::strcmp(arg, "--output") == 0) {
+            config.output = value;
+        } else if (std::strcmp(arg, "--filter") == 0) {
+            config.filter = value;
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return !config.threads.empty() && config.tasks > 0 &&
+           (config.format == "csv" || config.format == "json");
+}
+
+void WriteCsv(std::FILE* file, const std::vector<Result>& results) {
+    std::fprintf(file, "scenario,mode,threads,metric,value,unit\n");
+    for (const Result& r : results) {
+        std::fprintf(file, "%s,%s,%zu,%s,%.3f,%s\n", r.scenario.c_str(), r.mode.c_str(),
+                     r.threads, r.metric.c_str(), r.value, r.unit.c_str());
+    }
+}
+
+void WriteJson(std::FILE* file, const std::vector<Result>& results) {
+    std::fprintf(file, "[\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(file,
+                     "  {\"scenario\": \"%s\", \"mode\": \"%s\", \"threads\": %zu, "
+                     "\"metric\": \"%s\", \"value\": %.3f, \"unit\": \"%s\"}%s\n",
+                     r.scenario.c_str(), r.mode.c_str(), r.threads, r.metric.c_str(), r.value,
+                     r.unit.c_str(), i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!ParseArgs(argc, argv, config)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Result> results;
+    for (const Scenario& scenario : kScenarios) {
+        if (!config.filter.empty() && config.filter != scenario.name) {
+            continue;
+        }
+        for (size_t threads : config.threads) {
+            for (SchedulingMode mode : config.modes) {
+                // 每个场景使用新线程池，避免前一场景的队列容量与节点缓存影响结果
+                ThreadPool pool(ThreadPoolOptions{threads, mode});
+                Result base{scenario.name, ModeName(mode), threads, "", 0.0, ""};
+                scenario.run(pool, config, results, base);
+            }
+        }
+    }
+
+    std::FILE* file = config.output.empty() ? stdout : std::fopen(config.output.c_str(), "w");
+    if (!file) {
+        std::perror(config.output.c_str());
+        return 1;
+    }
+    if (config.format == "json") {
+        WriteJson(file, results);
+    } else {
+        WriteCsv(file, results);
+    }
+    if (file != stdout) {
+        std::fclose(file);
+    }
+    return 0;
+}
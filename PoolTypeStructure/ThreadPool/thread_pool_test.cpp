@@ -10,10 +10,73 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <new>
 #include "thread_pool.h"
 
 using namespace PoolTypeStructure;
 
+// 统计全局堆分配次数，用于验证零分配提交路径
+// 整族替换（数组、nothrow、带尺寸、对齐版本）：所有分配都走 CountedAlloc、释放都走 CountedFree，
+// 不会出现默认版本分配、替换版本释放的混用
+namespace {
+    std::atomic<size_t> g_allocCount{0};
+
+    void* CountedAlloc(std::size_t size, std::size_t align) noexcept {
+        g_allocCount.fetch_add(1, std::memory_order_relaxed);
+        if (size == 0) {
+            size = 1;
+        }
+        if (align <= alignof(std::max_align_t)) {
+            return std::malloc(size);
+        }
+        void* ptr = nullptr;
+        return posix_memalign(&ptr, align, size) == 0 ? ptr : nullptr;
+    }
+
+    void CountedFree(void* ptr) noexcept { std::free(ptr); }
+
+    void* CountedAllocOrThrow(std::size_t size, std::size_t align) {
+        if (void* ptr = CountedAlloc(size, align)) {
+            return ptr;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(std::size_t size) { return CountedAllocOrThrow(size, 0); }
+void* operator new[](std::size_t size) { return CountedAllocOrThrow(size, 0); }
+void* operator new(std::size_t size, std::align_val_t al) {
+    return CountedAllocOrThrow(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+    return CountedAllocOrThrow(size, static_cast<std::size_t>(al));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size, 0); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, static_cast<std::size_t>(al));
+}
+
+void operator delete(void* ptr) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+
 class ThreadPoolTest : public ::testing::Test {
 protected:
     void SetUp() override {
@@ -132,7 +195,479 @@ TEST(ThreadPoolDestructorTest, DestructorBehavior) {
     ASSERT_EQ(cleanup_count.load(), 10);
 }
 
+// 测试用例7：工作窃取模式基本功能
+TEST(WorkStealingThreadPoolTest, BasicFunctionality) {
+    ThreadPool pool(ThreadPoolOptions{4, SchedulingMode::WorkStealing});
+    std::atomic<int> counter{0};
+    constexpr int TASK_NUM = 1000;
+    std::vector<std::future<int>> futures;
+    futures.reserve(TASK_NUM);
+
+    for (int i = 0; i < TASK_NUM; ++i) {
+        futures.emplace_back(pool.SubmitTask([&counter, i]() {
+            counter.fetch_add(1, std::memory_order_relaxed);
+            return i;
+        }));
+    }
+
+    for (int i = 0; i < TASK_NUM; ++i) {
+        ASSERT_EQ(futures[i].get(), i);
+    }
+    ASSERT_EQ(counter.load(), TASK_NUM);
+}
+
+// 测试用例8：工作窃取模式下工作线程内部递归提交
+TEST(WorkStealingThreadPoolTest, NestedSubmission) {
+    constexpr int ROOTS = 16;
+    constexpr int CHILDREN = 200;
+    std::atomic<int> counter{0};
+    {
+        ThreadPool pool(ThreadPoolOptions{4, SchedulingMode::WorkStealing});
+        for (int i = 0; i < ROOTS; ++i) {
+            pool.SubmitTask([&pool, &counter]() {
+                for (int j = 0; j < CHILDREN; ++j) {
+                    pool.SubmitTask([&counter]() {
+                        counter.fetch_add(1, std::memory_order_relaxed);
+                    });
+                }
+            });
+        }
+    } // 析构时需排空所有本地队列
+
+    ASSERT_EQ(counter.load(), ROOTS * CHILDREN);
+}
+
+// 测试用例9：工作窃取模式异常传递
+TEST(WorkStealingThreadPoolTest, ExceptionHandling) {
+    ThreadPool pool(ThreadPoolOptions{2, SchedulingMode::WorkStealing});
+    auto future = pool.SubmitTask([&pool]() {
+        return pool.SubmitTask([]() -> int {
+            throw std::runtime_error("Nested exception");
+        });
+    });
+
+    EXPECT_THROW(future.get().get(), std::runtime_error);
+}
+
+// 测试用例10：Post提交及参数绑定
+TEST_F(ThreadPoolTest, PostWithArguments) {
+    std::atomic<int> sum{0};
+    constexpr int TASK_NUM = 100;
+    for (int i = 0; i < TASK_NUM; ++i) {
+        pool_->Post([&sum](int value) {
+            sum.fetch_add(value, std::memory_order_relaxed);
+        }, i);
+    }
+    pool_->Shutdown();
+
+    ASSERT_EQ(sum.load(), TASK_NUM * (TASK_NUM - 1) / 2);
+}
+
+// 测试用例11：Task支持只移动可调用体及超出内联容量的可调用体
+TEST(TaskTest, MoveOnlyAndLargeCallable) {
+    auto value = std::make_unique<int>(7);
+    int result = 0;
+    Task small([&result, value = std::move(value)]() { result += *value; });
+
+    char payload[Task::kInlineSize * 2] = {1};
+    Task large([&result, payload]() { result += payload[0]; });
+
+    Task moved(std::move(small));
+    ASSERT_FALSE(static_cast<bool>(small));
+    moved();
+    large();
+    ASSERT_EQ(result, 8);
+    ASSERT_EQ(sizeof(Task), 64u);
+}
+
+// 测试用例12：小型可调用体稳定状态下零堆分配
+TEST(TaskTest, PostWithoutAllocation) {
+    for (SchedulingMode mode : {SchedulingMode::SingleQueue, SchedulingMode::WorkStealing}) {
+        ThreadPool pool(ThreadPoolOptions{1, mode});
+        std::atomic<size_t> done{0};
+        constexpr size_t TASK_NUM = 1000;
+
+        auto runRound = [&pool, &done]() {
+            done.store(0);
+            for (size_t i = 0; i < TASK_NUM; ++i) {
+                pool.Post([&done]() { done.fetch_add(1, std::memory_order_release); });
+            }
+            while (done.load(std::memory_order_acquire) < TASK_NUM) {
+                std::this_thread::yield();
+            }
+        };
+
+        runRound(); // 预热：队列扩容、节点缓存填充
+        const size_t before = g_allocCount.load();
+        runRound();
+        EXPECT_EQ(g_allocCount.load() - before, 0u);
+    }
+}
+
+// 测试用例13：批量提交与门闩等待
+TEST_F(ThreadPoolTest, SubmitBatch) {
+    std::atomic<int> counter{0};
+    std::vector<std::function<void()>> batch(500, [&counter]() {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    });
+    batch.emplace_back([]() { throw std::runtime_error("Batch exception"); });
+
+    auto latch = pool_->SubmitBatch(std::move(batch));
+    EXPECT_THROW(latch->Wait(), std::runtime_error);
+    ASSERT_TRUE(latch->TryWait());
+    ASSERT_EQ(counter.load(), 500);
+}
+
+// 测试用例14：并行循环覆盖全部索引且仅执行一次
+TEST_F(ThreadPoolTest, ParallelFor) {
+    constexpr size_t N = 10007;
+    std::vector<int> hits(N, 0);
+    pool_->ParallelFor<size_t>(0, N, 64, [&hits](size_t i) { hits[i] += 1; });
+
+    for (size_t i = 0; i < N; ++i) {
+        ASSERT_EQ(hits[i], 1) << "index " << i;
+    }
+}
+
+// 测试用例15：工作线程内嵌套并行循环不会死锁
+TEST(WorkStealingThreadPoolTest, NestedParallelFor) {
+    for (SchedulingMode mode : {SchedulingMode::SingleQueue, SchedulingMode::WorkStealing}) {
+        ThreadPool pool(ThreadPoolOptions{2, mode});
+        std::atomic<long> sum{0};
+        pool.ParallelFor(0, 8, 1, [&pool, &sum](int outer) {
+            pool.ParallelFor(0, 100, 10, [&sum, outer](int inner) {
+                sum.fetch_add(outer * 100 + inner, std::memory_order_relaxed);
+            });
+        });
+        ASSERT_EQ(sum.load(), 800L * 799 / 2);
+    }
+}
+
+// 阻塞单个工作线程，便于在放行前按需排列队列中的任务
+class BlockedWorkerGuard {
+public:
+    explicit BlockedWorkerGuard(ThreadPool& pool) {
+        pool.Post([this]() {
+            started_.store(true);
+            while (!released_.load()) {
+                std::this_thread::yield();
+            }
+        });
+        while (!started_.load()) {
+            std::this_thread::yield();
+        }
+    }
+
+    void Release() { released_.store(true); }
+
+private:
+    std::atomic<bool> started_{false};
+    std::atomic<bool> released_{false};
+};
+
+// 测试用例16：通道间按优先级调度，Background受饥饿保护
+TEST(PriorityThreadPoolTest, LaneOrderAndStarvationProtection) {
+    ThreadPool pool(1);
+    std::vector<std::string> order;
+    BlockedWorkerGuard guard(pool);
+
+    constexpr int NORMAL_NUM = 2 * PriorityTaskQueue::kStarvationLimit;
+    pool.Post(TaskOptions{TaskPriority::Background}, [&order]() { order.push_back("B"); });
+    for (int i = 0; i < NORMAL_NUM; ++i) {
+        pool.Post([&order]() { order.push_back("N"); });
+    }
+    pool.Post(TaskOptions{TaskPriority::Realtime}, [&order]() { order.push_back("R"); });
+
+    guard.Release();
+    pool.Shutdown();
+
+    ASSERT_EQ(order.size(), static_cast<size_t>(NORMAL_NUM + 2));
+    EXPECT_EQ(order.front(), "R");
+    auto background = std::find(order.begin(), order.end(), "B");
+    ASSERT_NE(background, order.end());
+    EXPECT_LE(background - order.begin(), static_cast<long>(PriorityTaskQueue::kStarvationLimit));
+}
+
+// 测试用例17：通道内截止时间最早者优先，无截止时间任务保持FIFO并排在其后
+TEST(PriorityThreadPoolTest, EarliestDeadlineFirst) {
+    ThreadPool pool(1);
+    std::vector<int> order;
+    BlockedWorkerGuard guard(pool);
+
+    const auto now = TaskOptions::Clock::now();
+    pool.Post([&order]() { order.push_back(100); });
+    pool.Post([&order]() { order.push_back(101); });
+    for (int i = 3; i >= 1; --i) {
+        auto future = pool.SubmitTask(TaskOptions{TaskPriority::Normal, now + std::chrono::milliseconds(i)},
+                                      [&order, i]() { order.push_back(i); });
+    }
+
+    guard.Release();
+    pool.Shutdown();
+
+    ASSERT_EQ(order, (std::vector<int>{1, 2, 3, 100, 101}));
+}
+
+// 等待条件成立，超时返回false
+template <typename Pred>
+bool WaitUntil(Pred pred, std::chrono::milliseconds timeout = std::chrono::milliseconds(5000)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// 测试用例18：任务阻塞时扩容，空闲超时后回收到下限
+TEST(DynamicThreadPoolTest, GrowOnStallAndReapIdle) {
+    for (SchedulingMode mode : {SchedulingMode::SingleQueue, SchedulingMode::WorkStealing}) {
+        ThreadPoolOptions options;
+        options.threadNum = 1;
+        options.mode = mode;
+        options.minThreads = 1;
+        options.maxThreads = 4;
+        options.growWaitThreshold = std::chrono::milliseconds(5);
+        options.keepAlive = std::chrono::milliseconds(50);
+        ThreadPool pool(options);
+
+        // 4个相互等待的任务：只有线程池扩容到4个线程才能全部开始
+        constexpr int BLOCKING_TASKS = 4;
+        std::atomic<int> started{0};
+        std::atomic<bool> release{false};
+        for (int i = 0; i < BLOCKING_TASKS; ++i) {
+            pool.Post([&started, &release]() {
+                started.fetch_add(1);
+                while (!release.load()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+        }
+
+        EXPECT_TRUE(WaitUntil([&started]() { return started.load() == BLOCKING_TASKS; }));
+        EXPECT_EQ(pool.GetThreadCount(), 4u);
+        release.store(true);
+
+        EXPECT_TRUE(WaitUntil([&pool]() { return pool.GetThreadCount() == 1; }));
+
+        // 回收后仍可正常扩容与执行
+        auto future = pool.SubmitTask([]() { return 7; });
+        EXPECT_EQ(future.get(), 7);
+    }
+}
+
+// 测试用例19：线程数上下限不合法
+TEST(DynamicThreadPoolTest, InvalidBounds) {
+    ThreadPoolOptions options;
+    options.threadNum = 4;
+    options.maxThreads = 2;
+    EXPECT_THROW(ThreadPool pool(options), std::invalid_argument);
+
+    options.maxThreads = 0;
+    options.minThreads = 8;
+    EXPECT_THROW(ThreadPool pool(options), std::invalid_argument);
+}
+
+// 测试用例20：运行时统计（执行数、异常数、排队等待直方图、忙闲时长）
+TEST(ThreadPoolStatsTest, CountersAndWaitHistogram) {
+    static_assert(alignof(WorkerMetrics) == 64 && sizeof(WorkerMetrics) % 64 == 0,
+                  "WorkerMetrics must occupy whole cache lines");
+
+    for (SchedulingMode mode : {SchedulingMode::SingleQueue, SchedulingMode::WorkStealing}) {
+        ThreadPool pool(ThreadPoolOptions{2, mode});
+        constexpr size_t TASK_NUM = 200;
+        constexpr size_t THROW_NUM = 5;
+        for (size_t i = 0; i < TASK_NUM; ++i) {
+            pool.Post([i, &pool]() {
+                if (i < THROW_NUM) {
+                    throw std::runtime_error("stats");
+                }
+                if (i % 10 == 9) {
+                    pool.Post([]() { std::this_thread::sleep_for(std::chrono::microseconds(100)); });
+                }
+            });
+        }
+        pool.Shutdown();
+
+        const ThreadPoolStats stats = pool.GetStats();
+        ASSERT_EQ(stats.workers.size(), 2u);
+        const size_t expected = TASK_NUM + (TASK_NUM / 10);
+        EXPECT_EQ(stats.total.tasksExecuted, expected);
+        EXPECT_EQ(stats.total.exceptions, THROW_NUM);
+        EXPECT_EQ(stats.queuedTasks, 0u);
+        EXPECT_GT(stats.total.busyTime.count(), 0);
+
+        uint64_t waits = 0;
+        for (uint64_t count : stats.total.waitHistogram) {
+            waits += count;
+        }
+        EXPECT_EQ(waits, expected);
+
+        uint64_t perWorker = 0;
+        for (const WorkerStats& worker : stats.workers) {
+            perWorker += worker.tasksExecuted;
+        }
+        EXPECT_EQ(perWorker, stats.total.tasksExecuted);
+    }
+
+    EXPECT_EQ(WorkerStats::BucketUpperBound(0), std::chrono::microseconds(1));
+    EXPECT_EQ(WorkerStats::BucketUpperBound(kWaitHistogramBuckets - 1),
+              std::chrono::microseconds::max());
+}
+
+// 测试用例21：cpulist解析与紧凑/分散绑核顺序
+TEST(CpuTopologyTest, ParseAndPlacementOrder) {
+    EXPECT_EQ(CpuTopology::ParseCpuList("0-3,8,10-11\n"),
+              (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_TRUE(CpuTopology::ParseCpuList("").empty());
+
+    // 2个节点 x 2个物理核 x 2个超线程，超线程兄弟为(0,2)(1,3)(4,6)(5,7)
+    std::vector<CpuInfo> cpus;
+    for (int cpu = 0; cpu < 8; ++cpu) {
+        cpus.push_back(CpuInfo{cpu, cpu % 2, cpu / 4, cpu / 4});
+    }
+    CpuTopology topology(cpus);
+    EXPECT_EQ(topology.NodeCount(), 2u);
+    EXPECT_EQ(topology.NodeOf(5), 1);
+    EXPECT_EQ(topology.NodeOf(9), -1);
+    EXPECT_EQ(topology.CompactOrder(), (std::vector<int>{0, 2, 1, 3, 4, 6, 5, 7}));
+    EXPECT_EQ(topology.ScatterOrder(), (std::vector<int>{0, 4, 1, 5, 2, 6, 3, 7}));
+}
+
+// 测试用例22：显式绑核与NUMA模式
+TEST(CpuTopologyTest, PinnedAndNumaAwarePool) {
+    const CpuTopology topology = CpuTopology::Detect();
+    ASSERT_FALSE(topology.Cpus().empty());
+    const int cpu = topology.Cpus().back().cpu;
+
+    ThreadPoolOptions options;
+    options.threadNum = 2;
+    options.affinity = AffinityPolicy::Explicit;
+    options.cpuList = {cpu};
+    {
+        ThreadPool pool(options);
+        EXPECT_EQ(pool.SubmitTask([]() { return CurrentCpu(); }).get(), cpu);
+    }
+
+    options.cpuList = {1 << 20};
+    EXPECT_THROW(ThreadPool pool(options), std::invalid_argument);
+    options.cpuList.clear();
+    EXPECT_THROW(ThreadPool pool(options), std::invalid_argument);
+
+    for (SchedulingMode mode : {SchedulingMode::SingleQueue, SchedulingMode::WorkStealing}) {
+        ThreadPoolOptions numa;
+        numa.threadNum = 4;
+        numa.mode = mode;
+        numa.numaAware = true;
+        ThreadPool pool(numa);
+        std::atomic<int> sum{0};
+        pool.ParallelFor(0, 1000, 10, [&sum](int i) { sum.fetch_add(i); });
+        EXPECT_EQ(sum.load(), 999 * 1000 / 2);
+        EXPECT_EQ(pool.SubmitTask([]() { return 42; }).get(), 42);
+    }
+}
+
+// 测试用例23：任务图按依赖顺序执行，深链与宽扇出不阻塞工作线程
+TEST(TaskGraphTest, DependencyOrder) {
+    for (SchedulingMode mode : {SchedulingMode::SingleQueue, SchedulingMode::WorkStealing}) {
+        ThreadPool pool(ThreadPoolOptions{2, mode});
+        TaskGraph graph;
+
+        // 菱形：a -> {b, c} -> d
+        std::atomic<int> stage{0};
+        std::atomic<bool> ordered{true};
+        auto a = graph.AddNode([&stage]() { stage.store(1); });
+        auto check = [&stage, &ordered]() {
+            if (stage.load() != 1) ordered.store(false);
+        };
+        auto b = graph.Then(a, check);
+        auto c = graph.Then(a, check);
+        auto d = graph.AddNode([&stage]() { stage.store(2); });
+        graph.AddDependency(b, d);
+        graph.AddDependency(c, d);
+
+        // 深链 + 宽扇出扇入，节点数远超线程数
+        constexpr int CHAIN = 1000;
+        constexpr int WIDTH = 500;
+        std::vector<int> chain;
+        auto prev = graph.AddNode([&chain]() { chain.push_back(0); });
+        for (int i = 1; i < CHAIN; ++i) {
+            prev = graph.Then(prev, [&chain, i]() { chain.push_back(i); });
+        }
+        std::atomic<int> fanned{0};
+        auto join = graph.AddNode([&fanned, &ordered]() {
+            if (fanned.load() != WIDTH) ordered.store(false);
+        });
+        for (int i = 0; i < WIDTH; ++i) {
+            graph.AddDependency(graph.Then(prev, [&fanned]() { fanned.fetch_add(1); }), join);
+        }
+
+        for (int run = 0; run < 2; ++run) {
+            stage.store(0);
+            chain.clear();
+            fanned.store(0);
+            graph.Run(pool)->Wait();
+            EXPECT_TRUE(ordered.load());
+            EXPECT_EQ(stage.load(), 2);
+            ASSERT_EQ(chain.size(), static_cast<size_t>(CHAIN));
+            for (int i = 0; i < CHAIN; ++i) {
+                ASSERT_EQ(chain[i], i);
+            }
+        }
+    }
+}
+
+// 测试用例24：任务图异常传播与环检测
+TEST(TaskGraphTest, ExceptionAndCycle) {
+    ThreadPool pool(2);
+    TaskGraph graph;
+    std::atomic<bool> downstreamRan{false};
+    auto a = graph.AddNode([]() { throw std::runtime_error("graph"); });
+    graph.Then(a, [&downstreamRan]() { downstreamRan.store(true); });
+    EXPECT_THROW(graph.Run(pool)->Wait(), std::runtime_error);
+    EXPECT_FALSE(downstreamRan.load());
+
+    TaskGraph cyclic;
+    auto x = cyclic.AddNode([]() {});
+    auto y = cyclic.Then(x, []() {});
+    cyclic.AddDependency(y, x);
+    EXPECT_THROW(cyclic.Run(pool), std::invalid_argument);
+    EXPECT_THROW(cyclic.AddDependency(x, x), std::invalid_argument);
+    EXPECT_THROW(cyclic.AddDependency(x, 100), std::out_of_range);
+
+    TaskGraph empty;
+    EXPECT_TRUE(empty.Run(pool)->TryWait());
+}
+
+// 测试用例25：自旋预算随空闲间隔自适应
+TEST(AdaptiveSpinnerTest, BudgetFollowsIdleGap) {
+    AdaptiveSpinner spinner(std::chrono::microseconds(50));
+    EXPECT_TRUE(spinner.SpinUntil([]() { return true; }));
+
+    if (std::thread::hardware_concurrency() <= 1) {
+        EXPECT_EQ(spinner.SpinBudgetNs(), 0);  // 单核上不自旋
+        return;
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        spinner.RecordIdle(2000);  // 任务每2us到达
+    }
+    EXPECT_GT(spinner.SpinBudgetNs(), 0);
+    EXPECT_LE(spinner.SpinBudgetNs(), 50000);
+
+    for (int i = 0; i < 100; ++i) {
+        spinner.RecordIdle(10000000);  // 任务每10ms到达
+    }
+    EXPECT_EQ(spinner.SpinBudgetNs(), 0);
+    EXPECT_FALSE(spinner.SpinUntil([]() { return false; }));
+
+    AdaptiveSpinner disabled(std::chrono::microseconds(0));
+    EXPECT_EQ(disabled.SpinBudgetNs(), 0);
+}
+
 /*
-g++ -std=c++17 -pthread thread_pool.cpp thread_pool_test.cpp -lgtest_main -lgtest -o thread_pool_test
+g++ -std=c++17 -pthread thread_pool.cpp cpu_topology.cpp task_graph.cpp thread_pool_test.cpp -lgtest_main -lgtest -o thread_pool_test
 ./thread_pool_test
-*/
\ No newline at end of file
+*/
@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2025-2025 LiangHuDream
+ * MIT License. See LICENSE for details.
+ *
+ * Module:池式结构
+ * Description:Chase-Lev 无锁工作窃取双端队列
+ *
+ * Date:2025-04-30
+ * Author:LiangHuDream
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace PoolTypeStructure {
+
+/**
+ * @brief Chase-Lev 工作窃取双端队列
+ * @details 内存序参考 Lê et al.《Correct and Efficient Work-Stealing for
+ *          Weak Memory Models》(PPoPP'13)：
+ *          - 所有者线程在底部 Push/Pop，无需加锁
+ *          - 其他线程在顶部 Steal，仅在竞争最后一个元素时做一次CAS
+ *          - 容量不足时所有者线程自动扩容，旧数组延迟到析构时释放，
+ *            保证并发窃取者读取旧数组的安全
+ * @tparam T 元素类型，必须可平凡拷贝（通常为任务指针）
+ */
+template <typename T>
+class WorkStealingDeque final {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "WorkStealingDeque element must be trivially copyable");
+
+public:
+    /**
+     * @brief 构造函数
+     * @param[in] capacity 初始容量，向上取整为2的幂
+     */
+    explicit WorkStealingDeque(size_t capacity = 256)
+        : m_top(0), m_bottom(0) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        m_retired.emplace_back(new Array(cap));
+        m_array.store(m_retired.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /**
+     * @brief 压入底部（仅所有者线程调用）
+     * @param[in] item 待压入元素
+     */
+    void Push(T item) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        Array* a = m_array.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(a->capacity) - 1) {
+            a = Grow(a, b, t);
+        }
+        a->Store(b, item);
+        m_bottom.store(b + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 从底部弹出（仅所有者线程调用）
+     * @param[out] item 弹出的元素
+     * @return 成功返回true，队列为空返回false
+     */
+    bool Pop(T& item) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // 队列为空，恢复底部
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = a->Load(b);
+        if (t == b) {
+            // 最后一个元素，与窃取者竞争
+            bool won = m_top.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 从顶部窃取（任意线程调用）
+     * @param[out] item 窃取到的元素
+     * @return 成功返回true；队列为空或竞争失败返回false
+     */
+    bool Steal(T& item) {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+
+        Array* a = m_array.load(std::memory_order_acquire);
+        T value = a->Load(t);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                           std::memory_order_relaxed)) {
+            return false;
+        }
+        item = value;
+        return true;
+    }
+
+    /**
+     * @brief 近似元素个数（并发下仅作参考）
+     */
+    size_t Size() const {
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+private:
+    /// 环形缓冲区
+    struct Array {
+        explicit Array(size_t cap)
+            : capacity(cap), mask(cap - 1), slots(new std::atomic<T>[cap]) {}
+
+        T Load(int64_t index) const {
+            return slots[static_cast<size_t>(index) & mask].load(
+                std::memory_order_relaxed);
+        }
+
+        void Store(int64_t index, T value) {
+            slots[static_cast<size_t>(index) & mask].store(
+                value, std::memory_order_relaxed);
+        }
+
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Array* Grow(Array* old, int64_t bottom, int64_t top) {
+        m_retired.emplace_back(new Array(old->capacity * 2));
+        Array* a = m_retired.back().get();
+        for (int64_t i = top; i < bottom; ++i) {
+            a->Store(i, old->Load(i));
+        }
+        m_array.store(a, std::memory_order_release);
+        return a;
+    }
+
+    alignas(64) std::atomic<int64_t> m_top;     // 窃取端
+    alignas(64) std::atomic<int64_t> m_bottom;  // 所有者端
+    std::atomic<Array*> m_array;
+
+    /// 所有已分配的数组（含已被替换的旧数组），仅所有者线程修改
+    std::vector<std::unique_ptr<Array>> m_retired;
+};
+
+} // namespace PoolTypeStructure